@@ -0,0 +1,143 @@
+#pragma once
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include "Game.hpp"
+
+// Plays the game by itself, for unattended soak and performance runs
+// (--autopilot). It only reads the state a player could see, so its inputs
+// record and replay like a human's.
+//
+// Each sample it lines the gun up under the enemy that would reach the
+// bottom first, fires constantly, detours for power-ups when nothing is
+// urgent, steps out of the way of enemy projectiles, and restarts after a
+// game over.
+class Autopilot : public InputSource {
+public:
+    void sample(const Game& game, PlayerInput& input) override {
+        bool restart = input.restart;
+        input = PlayerInput();
+        input.restart = restart;
+
+        if (game.gameOver) {
+            input.restart = true;
+            return;
+        }
+        if (game.levelTransition) return;
+
+        sf::Vector2f rocket = game.players[game.localPlayer].position;
+        float gunX = rocket.x + GUN_OFFSET;
+        float homeY = game.height - 100.0f;
+
+        // Most urgent enemy the bullets can still reach
+        float bestTime = std::numeric_limits<float>::max();
+        float aimX = gunX;
+        for (uint32_t row = 0; row < game.enemies.size(); row++) {
+            sf::FloatRect bounds = game.enemyBounds(row);
+            if (bounds.position.y > rocket.y - 10) continue;   // already past the gun
+            float speed = std::max(game.enemies.get<Velocity>(row).value.y, 0.1f);
+            float time = (game.height - bounds.position.y) / speed;
+            if (time < bestTime) {
+                bestTime = time;
+                aimX = bounds.position.x + bounds.size.x / 2;
+            }
+        }
+
+        // Power-ups on the way down are worth a detour while nothing is close
+        float goalX = aimX;
+        float goalY = homeY;
+        if (bestTime > CALM_STEPS) {
+            float nearest = std::numeric_limits<float>::max();
+            for (uint32_t row = 0; row < game.powerUps.size(); row++) {
+                sf::Vector2f position = game.powerUps.get<Position>(row).value;
+                if (position.y < rocket.y - POWERUP_REACH) continue;
+                float distance = std::abs(position.x - gunX) + std::abs(position.y - rocket.y);
+                if (distance < nearest) {
+                    nearest = distance;
+                    goalX = position.x;
+                    goalY = position.y - 25;   // meet it with the middle of the rocket
+                }
+            }
+        }
+
+        float deadZone = game.playerSpeed / 2;
+        float dx = goalX - gunX;
+        float dy = std::min(goalY, homeY) - rocket.y;
+        input.left = dx < -deadZone;
+        input.right = dx > deadZone;
+        input.up = dy < -deadZone;
+        input.down = dy > deadZone;
+        input.fire = game.enemies.size() > 0;
+
+        if (!game.hasShield && game.projectiles.size() > 0) dodge(game, rocket, input);
+    }
+
+private:
+    // Keeps the chosen move unless a projectile would reach the core on it
+    // within LOOKAHEAD steps. Then of the nine ways to move it takes the
+    // one that stays clear longest, the one closest to the chosen move on
+    // a tie.
+    void dodge(const Game& game, sf::Vector2f rocket, PlayerInput& input) const {
+        const int MOVES = 9;
+        sf::Vector2f path[MOVES][LOOKAHEAD];   // core position after each step of each move
+        int clearFor[MOVES];
+        for (int m = 0; m < MOVES; m++) {
+            PlayerInput move = moveInput(m);
+            sf::Vector2f position = rocket;
+            for (int k = 0; k < LOOKAHEAD; k++) {
+                position = game.moveRocket(position, move);
+                path[m][k] = position + PLAYER_CORE;
+            }
+            clearFor[m] = LOOKAHEAD;
+        }
+
+        sf::Vector2f core = rocket + PLAYER_CORE;
+        for (size_t i = 0; i < game.projectiles.size(); i++) {
+            sf::Vector2f position = game.projectiles.position(i);
+            sf::Vector2f velocity = game.projectiles.velocity(i);
+            float radius = game.projectiles.radiusOf(i) + PLAYER_HITBOX_RADIUS + DODGE_MARGIN;
+            float reach = (std::abs(velocity.x) + std::abs(velocity.y) + 2 * game.playerSpeed) * LOOKAHEAD + radius;
+            if (std::abs(position.x - core.x) > reach || std::abs(position.y - core.y) > reach) continue;
+
+            for (int m = 0; m < MOVES; m++) {
+                for (int k = 0; k < clearFor[m]; k++) {
+                    sf::Vector2f gap = position + velocity * static_cast<float>(k + 1) - path[m][k];
+                    if (gap.x * gap.x + gap.y * gap.y < radius * radius) {
+                        clearFor[m] = k;
+                        break;
+                    }
+                }
+            }
+        }
+
+        int chosen = (input.right - input.left + 1) + 3 * (input.down - input.up + 1);
+        if (clearFor[chosen] == LOOKAHEAD) return;
+        int best = chosen;
+        for (int m = 0; m < MOVES; m++) {
+            int distance = std::abs(m % 3 - chosen % 3) + std::abs(m / 3 - chosen / 3);
+            int bestDistance = std::abs(best % 3 - chosen % 3) + std::abs(best / 3 - chosen / 3);
+            if (clearFor[m] > clearFor[best] || (clearFor[m] == clearFor[best] && distance < bestDistance)) best = m;
+        }
+        PlayerInput move = moveInput(best);
+        input.left = move.left;
+        input.right = move.right;
+        input.up = move.up;
+        input.down = move.down;
+    }
+
+    // Move `m` of nine: x = m % 3 and y = m / 3, each 0 back, 1 still, 2 forward
+    static PlayerInput moveInput(int m) {
+        PlayerInput move;
+        move.left = m % 3 == 0;
+        move.right = m % 3 == 2;
+        move.up = m / 3 == 0;
+        move.down = m / 3 == 2;
+        return move;
+    }
+
+    static constexpr int LOOKAHEAD = 24;            // steps ahead a projectile is dodged
+    static constexpr float DODGE_MARGIN = 4.0f;     // pixels kept clear of the hitbox
+    static constexpr float GUN_OFFSET = 26.0f;      // single shot's centre from the rocket's left edge
+    static constexpr float CALM_STEPS = 150.0f;     // steps before any enemy gets through
+    static constexpr float POWERUP_REACH = 200.0f;  // how far above the rocket to chase power-ups
+};
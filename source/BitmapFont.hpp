@@ -0,0 +1,330 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SoftwareCanvas.hpp"
+
+// Neon pixel font compiled into the executable.
+//
+// Glyphs are 5x7 bitmaps for printable ASCII plus the heart used by the
+// lives counter. Their metrics and the whole atlas (a crisp layer and a
+// soft glow layer) are computed at compile time, so showing text needs no
+// font file, no FreeType and no glyph rasterising during play: load()
+// uploads the finished atlas once, and text is textured quads from then on.
+
+const int GLYPH_WIDTH = 5;
+const int GLYPH_HEIGHT = 7;
+const int GLYPH_COUNT = 96;           // ' ' .. '~', then U+2665
+const int GLYPH_CELL_W = GLYPH_WIDTH + 2;    // 1 px border for the glow
+const int GLYPH_CELL_H = GLYPH_HEIGHT + 2;
+const int FONT_ATLAS_COLUMNS = 16;
+const int FONT_ATLAS_WIDTH = FONT_ATLAS_COLUMNS * GLYPH_CELL_W;
+const int FONT_LAYER_HEIGHT = (GLYPH_COUNT / FONT_ATLAS_COLUMNS) * GLYPH_CELL_H;
+const int FONT_ATLAS_HEIGHT = 2 * FONT_LAYER_HEIGHT;   // crisp layer on top, glow below
+
+// One byte per row, bit 4 is the leftmost column
+constexpr uint8_t GLYPH_ROWS[GLYPH_COUNT][GLYPH_HEIGHT] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},   // space
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04},   // !
+    {0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00},   // "
+    {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A},   // #
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04},   // $
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03},   // %
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D},   // &
+    {0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00},   // '
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02},   // (
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08},   // )
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00},   // *
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00},   // +
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08},   // ,
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00},   // -
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C},   // .
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00},   // /
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},   // 0
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},   // 1
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},   // 2
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},   // 3
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},   // 4
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},   // 5
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},   // 6
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},   // 7
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},   // 8
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},   // 9
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00},   // :
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08},   // ;
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02},   // <
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00},   // =
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08},   // >
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04},   // ?
+    {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E},   // @
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},   // A
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E},   // B
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},   // C
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C},   // D
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F},   // E
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},   // F
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F},   // G
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},   // H
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},   // I
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C},   // J
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},   // K
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F},   // L
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11},   // M
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},   // N
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},   // O
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10},   // P
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D},   // Q
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11},   // R
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E},   // S
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},   // T
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},   // U
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04},   // V
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A},   // W
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11},   // X
+    {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04},   // Y
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F},   // Z
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E},   // [
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00},   // backslash
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E},   // ]
+    {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00},   // ^
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F},   // _
+    {0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00},   // `
+    {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F},   // a
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E},   // b
+    {0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E},   // c
+    {0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F},   // d
+    {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E},   // e
+    {0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08},   // f
+    {0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E},   // g
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11},   // h
+    {0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E},   // i
+    {0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C},   // j
+    {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12},   // k
+    {0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},   // l
+    {0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11},   // m
+    {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11},   // n
+    {0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E},   // o
+    {0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10},   // p
+    {0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01},   // q
+    {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10},   // r
+    {0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E},   // s
+    {0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06},   // t
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D},   // u
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04},   // v
+    {0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A},   // w
+    {0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11},   // x
+    {0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E},   // y
+    {0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F},   // z
+    {0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02},   // {
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},   // |
+    {0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08},   // }
+    {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00},   // ~
+    {0x00, 0x0A, 0x1F, 0x1F, 0x0E, 0x04, 0x00},   // U+2665
+};
+
+struct GlyphMetrics {
+    uint8_t left;      // first lit column
+    uint8_t advance;   // pen movement in font pixels, spacing included
+};
+
+// Glyphs are trimmed to their lit columns plus one column of spacing.
+// Digits keep the full cell so numbers don't shift as they count.
+constexpr std::array<GlyphMetrics, GLYPH_COUNT> makeGlyphMetrics() {
+    std::array<GlyphMetrics, GLYPH_COUNT> metrics{};
+    for (int glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+        uint8_t used = 0;
+        for (int row = 0; row < GLYPH_HEIGHT; row++) used |= GLYPH_ROWS[glyph][row];
+
+        bool digit = glyph >= '0' - 32 && glyph <= '9' - 32;
+        if (used == 0) {
+            metrics[glyph] = GlyphMetrics{0, 3};
+        } else if (digit) {
+            metrics[glyph] = GlyphMetrics{0, GLYPH_WIDTH + 1};
+        } else {
+            int first = 0, last = GLYPH_WIDTH - 1;
+            while (!(used & (0x10 >> first))) first++;
+            while (!(used & (0x10 >> last))) last--;
+            metrics[glyph] = GlyphMetrics{static_cast<uint8_t>(first), static_cast<uint8_t>(last - first + 2)};
+        }
+    }
+    return metrics;
+}
+
+constexpr bool glyphPixel(int glyph, int x, int y) {
+    return x >= 0 && x < GLYPH_WIDTH && y >= 0 && y < GLYPH_HEIGHT && (GLYPH_ROWS[glyph][y] & (0x10 >> x));
+}
+
+// Alpha of every atlas pixel. The glow layer lights each lit pixel's
+// neighbours (sides brighter than corners) so text reads as a neon tube.
+constexpr std::array<uint8_t, FONT_ATLAS_WIDTH * FONT_ATLAS_HEIGHT> makeFontAtlas() {
+    std::array<uint8_t, FONT_ATLAS_WIDTH * FONT_ATLAS_HEIGHT> alpha{};
+    for (int glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+        int cellX = (glyph % FONT_ATLAS_COLUMNS) * GLYPH_CELL_W;
+        int cellY = (glyph / FONT_ATLAS_COLUMNS) * GLYPH_CELL_H;
+        for (int y = -1; y <= GLYPH_HEIGHT; y++) {
+            for (int x = -1; x <= GLYPH_WIDTH; x++) {
+                int crisp = (cellY + y + 1) * FONT_ATLAS_WIDTH + cellX + x + 1;
+                int glow = crisp + FONT_LAYER_HEIGHT * FONT_ATLAS_WIDTH;
+                if (glyphPixel(glyph, x, y)) {
+                    alpha[crisp] = 255;
+                    alpha[glow] = 200;
+                } else if (glyphPixel(glyph, x - 1, y) || glyphPixel(glyph, x + 1, y) ||
+                           glyphPixel(glyph, x, y - 1) || glyphPixel(glyph, x, y + 1)) {
+                    alpha[glow] = 110;
+                } else if (glyphPixel(glyph, x - 1, y - 1) || glyphPixel(glyph, x + 1, y - 1) ||
+                           glyphPixel(glyph, x - 1, y + 1) || glyphPixel(glyph, x + 1, y + 1)) {
+                    alpha[glow] = 45;
+                }
+            }
+        }
+    }
+    return alpha;
+}
+
+constexpr std::array<GlyphMetrics, GLYPH_COUNT> GLYPH_METRICS = makeGlyphMetrics();
+constexpr std::array<uint8_t, FONT_ATLAS_WIDTH * FONT_ATLAS_HEIGHT> FONT_ATLAS = makeFontAtlas();
+
+// Glyph index of a code point; anything the font lacks shows as '?'
+constexpr int glyphIndex(char32_t code) {
+    if (code >= 32 && code < 127) return static_cast<int>(code - 32);
+    if (code == 0x2665) return 95;
+    return '?' - 32;
+}
+
+class BitmapFont {
+public:
+    // Unpacks the baked atlas into white pixels with its alpha, then uploads
+    // them unless `upload` is false (that needs a GL context, so a window;
+    // the software renderer samples the pixels directly)
+    bool load(bool upload = true) {
+        std::vector<uint8_t> pixels(FONT_ATLAS.size() * 4, 255);
+        for (size_t i = 0; i < FONT_ATLAS.size(); i++) pixels[i * 4 + 3] = FONT_ATLAS[i];
+        image.assign(FONT_ATLAS_WIDTH, FONT_ATLAS_HEIGHT, pixels.data());
+        if (!upload) return true;
+        if (!atlas.resize(sf::Vector2u(FONT_ATLAS_WIDTH, FONT_ATLAS_HEIGHT))) return false;
+        atlas.update(pixels.data());
+        atlas.setSmooth(false);   // keep the pixels square when scaled up
+        return true;
+    }
+
+    const sf::Texture& texture() const { return atlas; }
+    const SoftwareCanvas& pixels() const { return image; }
+
+private:
+    sf::Texture atlas;
+    SoftwareCanvas image;
+};
+
+// Drop-in for the parts of sf::Text the HUD uses. Character sizes map to
+// whole-pixel scales of the 5x7 glyphs (28 -> 3x, 60 -> 6x).
+class BitmapText : public sf::Drawable, public sf::Transformable {
+public:
+    explicit BitmapText(const BitmapFont& font, const sf::String& string = "", unsigned int characterSize = 30)
+        : font(&font), string(string.begin(), string.end()), characterSize(characterSize) {
+        rebuild();
+    }
+
+    void setString(const sf::String& value) {
+        string.assign(value.begin(), value.end());
+        rebuild();
+    }
+
+    // These two reuse the string's storage, so text rewritten every frame
+    // stops allocating once it has been this long
+    void setString(const std::u32string& value) {
+        string = value;
+        rebuild();
+    }
+
+    void setString(const char* ascii) {
+        string.clear();
+        for (const char* c = ascii; *c; c++) string.push_back(static_cast<char32_t>(*c));
+        rebuild();
+    }
+
+    void setCharacterSize(unsigned int size) {
+        characterSize = size;
+        rebuild();
+    }
+
+    void setFillColor(sf::Color color) {
+        fillColor = color;
+        rebuild();
+    }
+
+    void setStyle(uint32_t value) {
+        style = value;
+        rebuild();
+    }
+
+    sf::FloatRect getLocalBounds() const { return bounds; }
+
+    void draw(sf::RenderTarget& target) const { target.draw(*this); }
+
+    // Only the position applies here (the HUD never rotates or scales text)
+    void draw(SoftwareCanvas& target) const {
+        target.drawTriangles(vertices, &font->pixels(), getPosition());
+    }
+
+protected:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override {
+        states.transform *= getTransform();
+        states.texture = &font->texture();
+        target.draw(vertices, states);
+    }
+
+private:
+    // Glow quads for the whole string first, then the crisp glyphs on top
+    void rebuild() {
+        vertices.clear();
+        float scale = static_cast<float>(std::max(1u, (characterSize + 4) / 10));
+        bool bold = style & sf::Text::Bold;
+        sf::Color glowColor(fillColor.r, fillColor.g, fillColor.b, static_cast<uint8_t>(fillColor.a / 2));
+
+        float width = 0;
+        for (int layer = 0; layer < 2; layer++) {
+            float penX = 0;
+            for (char32_t code : string) {
+                int glyph = glyphIndex(code);
+                const GlyphMetrics& metrics = GLYPH_METRICS[glyph];
+                float x = penX - metrics.left * scale;
+                if (layer == 0) {
+                    addGlyph(glyph, x, FONT_LAYER_HEIGHT, scale, glowColor);
+                } else {
+                    addGlyph(glyph, x, 0, scale, fillColor);
+                    if (bold) addGlyph(glyph, x + std::max(1.0f, scale / 2), 0, scale, fillColor);
+                }
+                penX += metrics.advance * scale;
+            }
+            width = std::max(0.0f, penX - scale);   // no spacing after the last glyph
+        }
+        bounds = sf::FloatRect(sf::Vector2f(0, 0), sf::Vector2f(width, GLYPH_HEIGHT * scale));
+    }
+
+    // The cell's 1 px border puts the glyph's top-left at (x, 0)
+    void addGlyph(int glyph, float x, int layerY, float scale, sf::Color color) {
+        sf::Vector2f t0(static_cast<float>((glyph % FONT_ATLAS_COLUMNS) * GLYPH_CELL_W),
+                        static_cast<float>((glyph / FONT_ATLAS_COLUMNS) * GLYPH_CELL_H + layerY));
+        sf::Vector2f t1 = t0 + sf::Vector2f(GLYPH_CELL_W, GLYPH_CELL_H);
+        sf::Vector2f p0(x - scale, -scale);
+        sf::Vector2f p1 = p0 + sf::Vector2f(GLYPH_CELL_W, GLYPH_CELL_H) * scale;
+
+        vertices.append(sf::Vertex{p0, color, t0});
+        vertices.append(sf::Vertex{sf::Vector2f(p1.x, p0.y), color, sf::Vector2f(t1.x, t0.y)});
+        vertices.append(sf::Vertex{sf::Vector2f(p0.x, p1.y), color, sf::Vector2f(t0.x, t1.y)});
+        vertices.append(sf::Vertex{sf::Vector2f(p0.x, p1.y), color, sf::Vector2f(t0.x, t1.y)});
+        vertices.append(sf::Vertex{sf::Vector2f(p1.x, p0.y), color, sf::Vector2f(t1.x, t0.y)});
+        vertices.append(sf::Vertex{p1, color, t1});
+    }
+
+    const BitmapFont* font;
+    std::u32string string;
+    unsigned int characterSize;
+    sf::Color fillColor = sf::Color::White;
+    uint32_t style = 0;
+    sf::VertexArray vertices{sf::PrimitiveType::Triangles};
+    sf::FloatRect bounds;
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "FrameArena.hpp"
+
+// Uniform-grid broad phase over the play field.
+//
+// Usage per tick: clear(), add() every box (its index is the order of the
+// add() calls), build(), then query. Boxes are cached, so each entity's
+// bounds are computed once per tick instead of once per tested pair.
+// Boxes outside the field are clamped into the border cells, so queries
+// never miss anything; the grid only decides which pairs get tested.
+// All storage comes from `arena` and only lasts until its next reset(), so
+// clear() starts every tick.
+class CollisionGrid {
+public:
+    CollisionGrid(float worldWidth, float worldHeight, float cellSize, FrameArena& arena)
+        : cellSize(cellSize),
+          cols(static_cast<int>(worldWidth / cellSize) + 1),
+          rows(static_cast<int>(worldHeight / cellSize) + 1),
+          boxes(arena), cellStart(arena), cellCursor(arena), cellItems(arena), visitedStamp(arena) {}
+
+    // `expectedBoxes` saves regrowing the box list a few times on the way up
+    void clear(size_t expectedBoxes = 0) {
+        boxes.fresh(expectedBoxes);
+        cellStart.fresh();
+        cellCursor.fresh();
+        cellItems.fresh();
+        visitedStamp.fresh();
+        stamp = 0;
+    }
+
+    int add(const sf::FloatRect& box) {
+        boxes.push_back(box);
+        return static_cast<int>(boxes.size()) - 1;
+    }
+
+    // Buckets the boxes into cells (counting sort: one pass to count, one to fill)
+    void build() {
+        cellStart.assign(cols * rows + 1, 0);
+        for (const auto& box : boxes) {
+            CellRange r = cellRange(box);
+            for (int cy = r.y0; cy <= r.y1; cy++)
+                for (int cx = r.x0; cx <= r.x1; cx++)
+                    cellStart[cy * cols + cx + 1]++;
+        }
+        for (size_t c = 1; c < cellStart.size(); c++) {
+            cellStart[c] += cellStart[c - 1];
+        }
+
+        cellItems.resize(cellStart.back());
+        cellCursor.assign(cellStart.begin(), cellStart.end() - 1);
+        for (size_t i = 0; i < boxes.size(); i++) {
+            CellRange r = cellRange(boxes[i]);
+            for (int cy = r.y0; cy <= r.y1; cy++)
+                for (int cx = r.x0; cx <= r.x1; cx++)
+                    cellItems[cellCursor[cy * cols + cx]++] = static_cast<int>(i);
+        }
+
+        visitedStamp.resize(boxes.size(), 0);
+    }
+
+    // Calls fn(index) once for every box overlapping `box`, in no particular order
+    template <typename F>
+    void forEachHit(const sf::FloatRect& box, F&& fn) const {
+        if (++stamp == 0) {
+            std::fill(visitedStamp.begin(), visitedStamp.end(), 0);
+            stamp = 1;
+        }
+        CellRange r = cellRange(box);
+        for (int cy = r.y0; cy <= r.y1; cy++) {
+            for (int cx = r.x0; cx <= r.x1; cx++) {
+                int cell = cy * cols + cx;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                    int i = cellItems[k];
+                    if (visitedStamp[i] == stamp) continue;
+                    visitedStamp[i] = stamp;
+                    if (overlaps(box, boxes[i])) fn(i);
+                }
+            }
+        }
+    }
+
+    const sf::FloatRect& bounds(int index) const { return boxes[index]; }
+    size_t size() const { return boxes.size(); }
+
+    // Same strict test as sf::FloatRect::findIntersection, without building the result
+    static bool overlaps(const sf::FloatRect& a, const sf::FloatRect& b) {
+        return std::max(a.position.x, b.position.x) < std::min(a.position.x + a.size.x, b.position.x + b.size.x) &&
+               std::max(a.position.y, b.position.y) < std::min(a.position.y + a.size.y, b.position.y + b.size.y);
+    }
+
+private:
+    struct CellRange {
+        int x0, y0, x1, y1;
+    };
+
+    CellRange cellRange(const sf::FloatRect& box) const {
+        return {clampCol(box.position.x), clampRow(box.position.y),
+                clampCol(box.position.x + box.size.x), clampRow(box.position.y + box.size.y)};
+    }
+
+    int clampCol(float x) const { return std::clamp(static_cast<int>(std::floor(x / cellSize)), 0, cols - 1); }
+    int clampRow(float y) const { return std::clamp(static_cast<int>(std::floor(y / cellSize)), 0, rows - 1); }
+
+    float cellSize;
+    int cols;
+    int rows;
+    FrameVector<sf::FloatRect> boxes;
+    FrameVector<int> cellStart;      // cols * rows + 1 offsets into cellItems
+    FrameVector<int> cellCursor;
+    FrameVector<int> cellItems;
+    mutable FrameVector<uint32_t> visitedStamp;
+    mutable uint32_t stamp = 0;
+};
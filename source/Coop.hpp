@@ -0,0 +1,709 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "Game.hpp"
+#include "NetCodec.hpp"
+#include "NetSocket.hpp"
+#include "TimeHistogram.hpp"
+
+// Two-player co-op over UDP.
+//
+// The host runs the only real simulation, with its own player and the
+// client's; lives, score and power-ups are shared. Every step it sends the
+// client the state (NetWorld) as a delta against the newest state the
+// client acknowledged. The client sends its input every step, together
+// with the previous INPUT_REDUNDANCY - 1 inputs so a lost packet costs
+// nothing, and draws the host's state moved on by velocity between
+// packets. Its own rocket is predicted: it moves at once, and when a state
+// arrives it is put where the host had it and the inputs the host hasn't
+// used yet are replayed on top.
+//
+// Every packet starts with COOP_PROTOCOL and a CoopPacket type:
+//   HELLO     client -> host, repeated until answered
+//   WELCOME   player index, archetype count (both ends need the same levels)
+//   FULL      the host already has a second player
+//   INPUT     sequence, acked tick + 1 (0 = none), count, input bits oldest first
+//   SNAPSHOT  tick, tick - baseline tick (0 = no baseline), last input used (0 = none), NetWorld
+const uint8_t COOP_PROTOCOL = 0x4E;
+const unsigned short DEFAULT_COOP_PORT = 7777;
+const int NET_HISTORY = 64;               // ticks of states and inputs kept; older baselines mean a full state
+const int INPUT_REDUNDANCY = 16;          // inputs per INPUT packet
+const int MAX_INPUT_LEAD = 3;             // client inputs the host buffers before skipping ahead
+const int64_t NET_TIMEOUT_US = 5000000;
+const int64_t HELLO_INTERVAL_US = 250000;
+
+enum class CoopPacket : uint8_t { HELLO = 1, WELCOME, FULL, INPUT, SNAPSHOT };
+
+// NetWorld contents
+enum CoopScalar {
+    SCALAR_SCORE, SCALAR_LIVES, SCALAR_COMBO, SCALAR_LEVEL, SCALAR_KILLS, SCALAR_KILLS_NEEDED,
+    SCALAR_FLAGS, SCALAR_PLAYERS, SCALAR_PATTERN,
+    SCALAR_PLAYER_X   // then x and y of each player, in 1/8 px
+};
+enum CoopList { LIST_ENEMIES, LIST_BULLETS, LIST_POWERUPS };
+enum CoopFlag {
+    FLAG_GAME_OVER = 1, FLAG_LEVEL_TRANSITION = 2, FLAG_RAPID_FIRE = 4, FLAG_SHIELD = 8, FLAG_TRIPLE_SHOT = 16,
+    FLAG_HOLD_FIRE = 32
+};
+
+static_assert(SCALAR_PLAYER_X + 2 * MAX_PLAYERS <= NetWorld::SCALARS, "player positions must fit the scalars");
+static_assert(MAX_ENEMIES <= 0x10000 && MAX_BULLETS <= 0x10000 && MAX_POWERUPS <= 0x10000, "netIds keep 16 bits of id");
+
+inline void beginPacket(std::vector<uint8_t>& packet, CoopPacket type) {
+    packet.clear();
+    packet.push_back(COOP_PROTOCOL);
+    packet.push_back(static_cast<uint8_t>(type));
+}
+
+// Host side: the authoritative game plus one remote player
+class CoopHost : public NetSession {
+public:
+    std::function<int64_t()> clock = inputClockUs;   // --coop-test swaps in simulated time
+
+    CoopHost(const LinkConditions& link, uint32_t seed) { socket.setConditions(link, seed); }
+
+    bool listen(unsigned short port) { return socket.bind(port); }
+    unsigned short port() const { return socket.port(); }
+
+    void step(Game& game) override {
+        int64_t now = clock();
+        receivePackets(game, now);
+        if (remote.connected && now - remote.lastHeardUs > NET_TIMEOUT_US) {
+            std::cerr << "player 2 timed out\n";
+            remote.connected = false;
+            game.playerCount = 1;
+        }
+        if (remote.connected) game.players[REMOTE_PLAYER].input = nextRemoteInput();
+
+        int64_t start = inputClockUs();
+        game.step();
+        tick++;
+        NetWorld& world = history[tick % NET_HISTORY];
+        captureWorld(game, world);
+        world.tick = tick;
+        if (remote.connected) sendSnapshot(world);
+        tickCost.add(inputClockUs() - start);
+    }
+
+    void report() const override {
+        std::cout << "co-op host: " << tick << " ticks, " << snapshots << " snapshots (" << fullSnapshots << " full), "
+                  << (snapshots ? static_cast<double>(snapshotBytes) / snapshots : 0.0) << " bytes each on average, "
+                  << maxSnapshotBytes << " max\n";
+        std::cout << "  received " << socket.bytesReceived << " bytes in " << socket.packetsReceived << " packets, "
+                  << socket.packetsDropped << " dropped by --loss, " << remote.inputsMissed << " client inputs missing\n";
+        std::cout << "  tick cost (step + capture + encode + send): p50 " << tickCost.percentileMs(50) << " ms, p95 "
+                  << tickCost.percentileMs(95) << " ms, p99 " << tickCost.percentileMs(99) << " ms, max "
+                  << tickCost.maxMs() << " ms\n";
+    }
+
+    // The tick of the newest state sent
+    uint32_t lastTick() const { return tick; }
+
+    // The state sent for `tick`, while it is still in the history
+    const NetWorld* stateAt(uint32_t at) const {
+        const NetWorld& world = history[at % NET_HISTORY];
+        return world.tick == at && tick - at < NET_HISTORY ? &world : nullptr;
+    }
+
+    static void captureWorld(const Game& game, NetWorld& world) {
+        int32_t* scalars = world.scalars;
+        scalars[SCALAR_SCORE] = game.score;
+        scalars[SCALAR_LIVES] = game.lives;
+        scalars[SCALAR_COMBO] = game.combo;
+        scalars[SCALAR_LEVEL] = game.currentLevel;
+        scalars[SCALAR_KILLS] = game.enemiesKilledInLevel;
+        scalars[SCALAR_KILLS_NEEDED] = game.enemiesNeededForNextLevel;
+        scalars[SCALAR_FLAGS] = (game.gameOver ? FLAG_GAME_OVER : 0) | (game.levelTransition ? FLAG_LEVEL_TRANSITION : 0) |
+                                (game.rapidFire ? FLAG_RAPID_FIRE : 0) | (game.hasShield ? FLAG_SHIELD : 0) |
+                                (game.hasTripleShot ? FLAG_TRIPLE_SHOT : 0) | (game.patternCooldown > 0 ? FLAG_HOLD_FIRE : 0);
+        scalars[SCALAR_PLAYERS] = game.playerCount;
+        scalars[SCALAR_PATTERN] = game.patternStep;
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            scalars[SCALAR_PLAYER_X + 2 * p] = NetEntity::quantise(game.players[p].position.x, NetEntity::POSITION_UNITS);
+            scalars[SCALAR_PLAYER_X + 2 * p + 1] = NetEntity::quantise(game.players[p].position.y, NetEntity::POSITION_UNITS);
+        }
+
+        std::vector<NetEntity>& enemies = world.lists[LIST_ENEMIES];
+        enemies.clear();
+        for (uint32_t row = 0; row < game.enemies.size(); row++) {
+            const Health& health = game.enemies.get<Health>(row);
+            enemies.push_back(entity(game.enemies.entityAt(row), game.enemies.get<Position>(row).value,
+                                     game.enemies.get<Velocity>(row).value, game.enemies.get<EnemyKind>(row).archetype,
+                                     health.current, health.max));
+        }
+        std::vector<NetEntity>& bullets = world.lists[LIST_BULLETS];
+        bullets.clear();
+        for (uint32_t row = 0; row < game.bullets.size(); row++) {
+            bullets.push_back(entity(game.bullets.entityAt(row), game.bullets.get<Position>(row).value,
+                                     sf::Vector2f(0, -game.bulletSpeed), game.bullets.get<BulletKind>(row).tripleShot, 0, 0));
+        }
+        std::vector<NetEntity>& powerUps = world.lists[LIST_POWERUPS];
+        powerUps.clear();
+        for (uint32_t row = 0; row < game.powerUps.size(); row++) {
+            powerUps.push_back(entity(game.powerUps.entityAt(row), game.powerUps.get<Position>(row).value, sf::Vector2f(0, 2),
+                                      static_cast<int32_t>(game.powerUps.get<PowerUpKind>(row).type), 0, 0));
+        }
+        for (std::vector<NetEntity>& list : world.lists) {
+            std::sort(list.begin(), list.end(), [](const NetEntity& a, const NetEntity& b) { return a.netId < b.netId; });
+        }
+    }
+
+private:
+    static constexpr int REMOTE_PLAYER = 1;
+
+    struct Remote {
+        bool connected = false;
+        NetAddress address;
+        int64_t lastHeardUs = 0;
+        bool hasAck = false;
+        uint32_t ackTick = 0;       // newest state the client has
+        bool hasInputs = false;
+        uint32_t newestSeq = 0;
+        uint32_t nextSeq = 0;       // input for the next step
+        uint32_t usedSeq = 0;       // last one stepped with, 0 = none yet (client sequences start at 1)
+        uint8_t lastBits = 0;
+        uint8_t inputs[NET_HISTORY] = {};
+        uint32_t inputSeqs[NET_HISTORY] = {};
+        uint64_t inputsMissed = 0;
+    };
+
+    static NetEntity entity(Entity handle, sf::Vector2f position, sf::Vector2f velocity, int32_t a, int32_t b, int32_t c) {
+        NetEntity out;
+        out.netId = handle.id | (handle.generation << 16);
+        out.field[0] = NetEntity::quantise(position.x, NetEntity::POSITION_UNITS);
+        out.field[1] = NetEntity::quantise(position.y, NetEntity::POSITION_UNITS);
+        out.field[2] = NetEntity::quantise(velocity.x, NetEntity::VELOCITY_UNITS);
+        out.field[3] = NetEntity::quantise(velocity.y, NetEntity::VELOCITY_UNITS);
+        out.field[4] = a;
+        out.field[5] = b;
+        out.field[6] = c;
+        return out;
+    }
+
+    void receivePackets(Game& game, int64_t now) {
+        NetAddress from;
+        while (socket.receive(now, packet, from)) {
+            ByteReader in(packet.data(), packet.size());
+            if (in.byte() != COOP_PROTOCOL) continue;
+            CoopPacket type = static_cast<CoopPacket>(in.byte());
+
+            if (type == CoopPacket::HELLO) {
+                if (remote.connected && !(remote.address == from)) {
+                    beginPacket(reply, CoopPacket::FULL);
+                    socket.send(reply, from);
+                    continue;
+                }
+                if (!remote.connected) join(game, from, now);   // else our WELCOME got lost
+                beginPacket(reply, CoopPacket::WELCOME);
+                ByteWriter out(reply);
+                out.byte(REMOTE_PLAYER);
+                out.varint(static_cast<uint64_t>(game.waves.archetypeCount()));
+                socket.send(reply, from);
+            } else if (type == CoopPacket::INPUT && remote.connected && remote.address == from) {
+                readInput(in, now);
+            }
+        }
+    }
+
+    void join(Game& game, const NetAddress& from, int64_t now) {
+        remote = Remote();
+        remote.connected = true;
+        remote.address = from;
+        remote.lastHeardUs = now;
+        game.playerCount = 2;
+        game.players[REMOTE_PLAYER] = Player();
+        game.players[REMOTE_PLAYER].position = game.spawnPosition(REMOTE_PLAYER);
+        game.players[REMOTE_PLAYER].prevPosition = game.players[REMOTE_PLAYER].position;
+        std::cout << "player 2 joined from " << from.ip.toString() << ":" << from.port << "\n";
+    }
+
+    void readInput(ByteReader& in, int64_t now) {
+        uint32_t seq = static_cast<uint32_t>(in.varint());
+        uint64_t ack = in.varint();
+        int count = in.byte();
+        uint8_t bits[INPUT_REDUNDANCY];
+        if (count < 1 || count > INPUT_REDUNDANCY || seq < static_cast<uint32_t>(count)) return;
+        for (int i = 0; i < count; i++) bits[i] = in.byte();
+        if (!in.ok()) return;
+
+        remote.lastHeardUs = now;
+        if (ack > 0) {
+            uint32_t ackTick = static_cast<uint32_t>(ack - 1);
+            if (!remote.hasAck || static_cast<int32_t>(ackTick - remote.ackTick) > 0) remote.ackTick = ackTick;
+            remote.hasAck = true;
+        }
+        if (!remote.hasInputs) {
+            remote.hasInputs = true;
+            remote.nextSeq = seq;
+            remote.newestSeq = seq;
+        }
+        for (int i = 0; i < count; i++) {
+            uint32_t inputSeq = seq - static_cast<uint32_t>(count - 1 - i);
+            if (static_cast<int32_t>(inputSeq - remote.nextSeq) < 0) continue;   // already stepped past
+            remote.inputs[inputSeq % NET_HISTORY] = bits[i];
+            remote.inputSeqs[inputSeq % NET_HISTORY] = inputSeq;
+        }
+        if (static_cast<int32_t>(seq - remote.newestSeq) > 0) remote.newestSeq = seq;
+    }
+
+    // The client's input for this step. A late one is waited for by
+    // repeating the previous input; one that is gone for good (newer ones
+    // arrived without it) is skipped, and so are inputs piling up beyond
+    // MAX_INPUT_LEAD, so the client's controls never lag further behind.
+    PlayerInput nextRemoteInput() {
+        PlayerInput repeat = PlayerInput::fromBits(remote.lastBits);
+        repeat.restart = false;
+        if (!remote.hasInputs) return repeat;
+
+        if (static_cast<int32_t>(remote.newestSeq - remote.nextSeq) > MAX_INPUT_LEAD) {
+            remote.nextSeq = remote.newestSeq - 1;
+        }
+        bool arrived = static_cast<int32_t>(remote.newestSeq - remote.nextSeq) >= 0;
+        uint32_t slot = remote.nextSeq % NET_HISTORY;
+        if (arrived && remote.inputSeqs[slot] == remote.nextSeq) {
+            remote.lastBits = remote.inputs[slot];
+            remote.usedSeq = remote.nextSeq++;
+            return PlayerInput::fromBits(remote.lastBits);
+        }
+        if (arrived) remote.usedSeq = remote.nextSeq++;
+        remote.inputsMissed++;
+        return repeat;
+    }
+
+    void sendSnapshot(const NetWorld& world) {
+        const NetWorld* baseline = remote.hasAck ? stateAt(remote.ackTick) : nullptr;
+        if (baseline == &world) baseline = nullptr;
+
+        beginPacket(packet, CoopPacket::SNAPSHOT);
+        ByteWriter out(packet);
+        out.varint(world.tick);
+        out.varint(baseline ? world.tick - baseline->tick : 0);
+        out.varint(remote.usedSeq);
+        world.encode(out, baseline);
+        socket.send(packet, remote.address);
+
+        snapshots++;
+        if (!baseline) fullSnapshots++;
+        snapshotBytes += packet.size();
+        maxSnapshotBytes = std::max<uint64_t>(maxSnapshotBytes, packet.size());
+    }
+
+    NetSocket socket;
+    Remote remote;
+    uint32_t tick = 0;
+    NetWorld history[NET_HISTORY];
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> reply;
+
+    uint64_t snapshots = 0;
+    uint64_t fullSnapshots = 0;
+    uint64_t snapshotBytes = 0;
+    uint64_t maxSnapshotBytes = 0;
+    TimeHistogram tickCost{10, 1000};
+};
+
+// Client side: the game it runs is only a replica of the host's. Its
+// tables are kept in line with the received states entity by entity (not
+// rebuilt), so bullet trails and particles carry on across packets.
+class CoopClient : public NetSession {
+public:
+    std::function<int64_t()> clock = inputClockUs;   // --coop-test swaps in simulated time
+
+    CoopClient(const NetAddress& host, const LinkConditions& link, uint32_t seed) : host(host) {
+        socket.setConditions(link, seed);
+    }
+
+    bool open() { return socket.bind(sf::Socket::AnyPort); }
+
+    void step(Game& game) override {
+        int64_t now = clock();
+        displayTick++;
+        shownPattern++;
+        for (int p = 0; p < game.playerCount; p++) {
+            game.players[p].prevPosition = game.players[p].position;
+        }
+
+        if (state == State::CONNECTING && now - lastHelloUs >= HELLO_INTERVAL_US) {
+            lastHelloUs = now;
+            beginPacket(packet, CoopPacket::HELLO);
+            socket.send(packet, host);
+        }
+        if (state == State::PLAYING) sendInput(game, now);
+
+        const NetWorld* world = receivePackets(game, now);
+        if (state == State::PLAYING) {
+            if (world) {
+                applyWorld(game, *world);
+            } else {
+                deadReckon(game);
+            }
+            predictRocket(game, world != nullptr);
+            if (!game.gameOver && !game.levelTransition) advanceProjectiles(game);
+            if (now - lastHeardUs > NET_TIMEOUT_US) {
+                std::cerr << "lost the host, reconnecting\n";
+                state = State::CONNECTING;
+            }
+        }
+
+        // Effects and the starfield run here; the host doesn't send them
+        game.updateShake(SIM_DT);
+        PowerUpKind* kind = game.powerUps.column<PowerUpKind>();
+        for (uint32_t row = 0; row < game.powerUps.size(); row++) kind[row].age += SIM_DT;
+        game.updateParticles(SIM_DT);
+        game.updateTrails();
+        game.updateStars();
+    }
+
+    void report() const override {
+        std::cout << "co-op client: " << snapshots << " snapshots, " << snapshotsLost << " lost, " << snapshotsStale
+                  << " stale, " << snapshotsBad << " undecodable, "
+                  << (snapshots ? static_cast<double>(snapshotBytes) / snapshots : 0.0) << " bytes each on average\n";
+        std::cout << "  sent " << socket.bytesSent << " bytes in " << socket.packetsSent << " packets, "
+                  << socket.packetsDropped << " dropped by --loss, " << corrections << " prediction corrections\n";
+        if (roundTrip.count() > 0) {
+            std::cout << "  input round trip: p50 " << roundTrip.percentileMs(50) << " ms, p95 " << roundTrip.percentileMs(95)
+                      << " ms, p99 " << roundTrip.percentileMs(99) << " ms, max " << roundTrip.maxMs() << " ms\n";
+        }
+    }
+
+    // The newest state received, for checking against the host's
+    const NetWorld* newestState() const { return hasNewest ? &history[newestTick % NET_HISTORY] : nullptr; }
+
+    // The host tick the world is shown at, a little ahead of newestState()
+    // when packets are late
+    uint32_t shownTick() const { return displayTick; }
+
+    bool failed() const { return state == State::FAILED; }
+
+private:
+    enum class State { CONNECTING, PLAYING, FAILED };
+
+    // Which table entity a netId is replicated into
+    struct Replica {
+        uint32_t netId;
+        Entity entity;
+    };
+
+    void sendInput(Game& game, int64_t now) {
+        PlayerInput& input = game.players[game.localPlayer].input;
+        seq++;
+        inputBits[seq % NET_HISTORY] = input.toBits();
+        sentUs[seq % NET_HISTORY] = now;
+        input.restart = false;   // sent; the host applies it
+
+        beginPacket(packet, CoopPacket::INPUT);
+        ByteWriter out(packet);
+        out.varint(seq);
+        out.varint(hasNewest ? newestTick + 1 : 0);
+        uint32_t count = std::min<uint32_t>(seq, INPUT_REDUNDANCY);
+        out.byte(static_cast<uint8_t>(count));
+        for (uint32_t s = seq - count + 1; s <= seq; s++) out.byte(inputBits[s % NET_HISTORY]);
+        socket.send(packet, host);
+    }
+
+    // Decodes everything that arrived and returns the newest state, if any
+    const NetWorld* receivePackets(Game& game, int64_t now) {
+        const NetWorld* newest = nullptr;
+        NetAddress from;
+        while (socket.receive(now, packet, from)) {
+            if (!(from == host)) continue;
+            ByteReader in(packet.data(), packet.size());
+            if (in.byte() != COOP_PROTOCOL) continue;
+            CoopPacket type = static_cast<CoopPacket>(in.byte());
+            lastHeardUs = now;
+
+            if (type == CoopPacket::WELCOME && state == State::CONNECTING) {
+                int player = in.byte();
+                uint64_t archetypes = in.varint();
+                if (!in.ok() || player >= MAX_PLAYERS) continue;
+                if (archetypes != static_cast<uint64_t>(game.waves.archetypeCount())) {
+                    std::cerr << "the host plays different levels (--levels), can't join\n";
+                    state = State::FAILED;
+                    continue;
+                }
+                start(game, player);
+            } else if (type == CoopPacket::FULL && state == State::CONNECTING) {
+                std::cerr << "the host already has two players\n";
+                state = State::FAILED;
+            } else if (type == CoopPacket::SNAPSHOT && state == State::PLAYING) {
+                const NetWorld* world = readSnapshot(in, now, packet.size());
+                if (world) newest = world;
+            }
+        }
+        return newest;
+    }
+
+    void start(Game& game, int player) {
+        state = State::PLAYING;
+        game.localPlayer = player;
+        game.enemies.clear();
+        game.bullets.clear();
+        game.powerUps.clear();
+        game.projectiles.clear();
+        replicas[LIST_ENEMIES].clear();
+        replicas[LIST_BULLETS].clear();
+        replicas[LIST_POWERUPS].clear();
+        hasNewest = false;
+        ackedSeq = 0;
+        shownPattern = 0;
+        lastHostPattern = 0;
+        std::cout << "joined as player " << player + 1 << "\n";
+    }
+
+    const NetWorld* readSnapshot(ByteReader& in, int64_t now, size_t bytes) {
+        uint32_t tick = static_cast<uint32_t>(in.varint());
+        uint32_t gap = static_cast<uint32_t>(in.varint());
+        uint32_t usedSeq = static_cast<uint32_t>(in.varint());
+        if (!in.ok()) return nullptr;
+        if (hasNewest && static_cast<int32_t>(tick - newestTick) <= 0) {
+            snapshotsStale++;   // overtaken by a newer one
+            return nullptr;
+        }
+
+        const NetWorld* baseline = nullptr;
+        if (gap > 0) {
+            const NetWorld& candidate = history[(tick - gap) % NET_HISTORY];
+            if (gap >= NET_HISTORY || candidate.tick != tick - gap) {
+                snapshotsBad++;
+                return nullptr;
+            }
+            baseline = &candidate;
+        }
+        NetWorld& world = history[tick % NET_HISTORY];
+        if (!world.decode(in, baseline, tick)) {
+            world.tick = tick + 1;   // matches no lookup of this slot, so it can't become a baseline
+            snapshotsBad++;
+            return nullptr;
+        }
+
+        if (hasNewest) snapshotsLost += tick - newestTick - 1;
+        hasNewest = true;
+        newestTick = tick;
+        snapshots++;
+        snapshotBytes += bytes;
+        if (static_cast<int32_t>(usedSeq - ackedSeq) > 0) {
+            if (seq - usedSeq < NET_HISTORY) roundTrip.add(now - sentUs[usedSeq % NET_HISTORY]);
+            ackedSeq = usedSeq;
+        }
+        return &world;
+    }
+
+    void applyWorld(Game& game, const NetWorld& world) {
+        const int32_t* scalars = world.scalars;
+        bool wasOver = game.gameOver;
+        bool lifeLost = scalars[SCALAR_LIVES] < game.lives;
+        game.score = scalars[SCALAR_SCORE];
+        game.lives = scalars[SCALAR_LIVES];
+        game.combo = scalars[SCALAR_COMBO];
+        game.currentLevel = scalars[SCALAR_LEVEL];
+        game.enemiesKilledInLevel = scalars[SCALAR_KILLS];
+        game.enemiesNeededForNextLevel = scalars[SCALAR_KILLS_NEEDED];
+        game.gameOver = scalars[SCALAR_FLAGS] & FLAG_GAME_OVER;
+        game.levelTransition = scalars[SCALAR_FLAGS] & FLAG_LEVEL_TRANSITION;
+        game.rapidFire = scalars[SCALAR_FLAGS] & FLAG_RAPID_FIRE;
+        game.hasShield = scalars[SCALAR_FLAGS] & FLAG_SHIELD;
+        game.hasTripleShot = scalars[SCALAR_FLAGS] & FLAG_TRIPLE_SHOT;
+        game.playerCount = std::min(std::max(scalars[SCALAR_PLAYERS], 1), MAX_PLAYERS);
+        for (int p = 0; p < game.playerCount; p++) {
+            if (p != game.localPlayer) game.players[p].position = playerPosition(world, p);
+        }
+
+        // Shown a little ahead of the newest state when packets came in late,
+        // so jitter doesn't make everything stutter back and forth
+        if (static_cast<int32_t>(displayTick - world.tick) < 0 ||
+            static_cast<int32_t>(displayTick - world.tick) > MAX_INPUT_LEAD) {
+            displayTick = world.tick;
+        }
+        int32_t lead = static_cast<int32_t>(displayTick - world.tick);
+
+        // The host's pattern clock at displayTick. The state carries it after
+        // its step, so the volley for this step is the one before. The clock
+        // going back means a new boss.
+        shownPattern = std::max(scalars[SCALAR_PATTERN] + lead - 1, 0);
+        if (scalars[SCALAR_PATTERN] < lastHostPattern) game.patternStep = shownPattern;
+        lastHostPattern = scalars[SCALAR_PATTERN];
+        game.patternCooldown = scalars[SCALAR_FLAGS] & FLAG_HOLD_FIRE ? PATTERN_GRACE : 0.0f;
+
+        // Enemies cleared for a new level or a restart go without explosions
+        bool cleared = game.levelTransition || wasOver != game.gameOver;
+        if (cleared || lifeLost) game.projectiles.clear();   // as the host clears them
+        sync(game.enemies, replicas[LIST_ENEMIES], world.lists[LIST_ENEMIES], lead,
+             [&](uint32_t row, const NetEntity& entity, bool) {
+                 int archetype = std::min(std::max(entity.field[4], 0), game.waves.archetypeCount() - 1);
+                 game.enemies.get<Position>(row).value = position(entity);
+                 game.enemies.get<Velocity>(row).value = velocity(entity);
+                 game.enemies.get<Health>(row) = Health{entity.field[5], entity.field[6]};
+                 game.enemies.get<EnemyKind>(row).archetype = archetype;
+                 if (game.waves.archetype(archetype).flags & ARCHETYPE_BOSS) game.bossEntity = game.enemies.entityAt(row);
+             },
+             [&](uint32_t row) {
+                 if (cleared) return;
+                 sf::Vector2f where = game.enemies.get<Position>(row).value;
+                 const uint8_t* color = game.waves.archetype(game.enemies.get<EnemyKind>(row).archetype).color;
+                 game.createExplosion(where, where.y > game.height - 40.0f ? sf::Color::Red
+                                                                            : sf::Color(color[0], color[1], color[2], color[3]));
+             });
+        sync(game.bullets, replicas[LIST_BULLETS], world.lists[LIST_BULLETS], lead,
+             [&](uint32_t row, const NetEntity& entity, bool created) {
+                 game.bullets.get<Position>(row).value = position(entity);
+                 game.bullets.get<BulletKind>(row).tripleShot = entity.field[4] != 0;
+                 if (created) {
+                     game.bullets.get<Trail>(row) = Trail{{}, 0, 0};
+                     game.bullets.get<Trail>(row).push(position(entity));
+                 }
+             },
+             [](uint32_t) {});
+        sync(game.powerUps, replicas[LIST_POWERUPS], world.lists[LIST_POWERUPS], lead,
+             [&](uint32_t row, const NetEntity& entity, bool created) {
+                 game.powerUps.get<Position>(row).value = position(entity);
+                 PowerUpKind& kind = game.powerUps.get<PowerUpKind>(row);
+                 kind.type = static_cast<PowerUpType>(std::min(std::max(entity.field[4], 0), 2));
+                 if (created) kind.age = 0.0f;
+             },
+             [](uint32_t) {});
+    }
+
+    // Brings `table` in line with `list`: entities still there are updated
+    // in place, new ones created and the rest destroyed (`removed` runs
+    // first). Both `replicas` and `list` are sorted by netId.
+    template <typename Table, typename Write, typename Remove>
+    void sync(Table& table, std::vector<Replica>& replicas, const std::vector<NetEntity>& list, int32_t lead,
+              Write write, Remove removed) {
+        auto destroy = [&](Entity entity) {
+            uint32_t row = table.rowOf(entity);
+            if (row == Table::NO_ROW) return;
+            removed(row);
+            table.destroy(row);
+        };
+
+        kept.clear();
+        size_t old = 0;
+        for (const NetEntity& received : list) {
+            while (old < replicas.size() && replicas[old].netId < received.netId) destroy(replicas[old++].entity);
+            Entity entity;
+            uint32_t row = Table::NO_ROW;
+            if (old < replicas.size() && replicas[old].netId == received.netId) {
+                entity = replicas[old++].entity;
+                row = table.rowOf(entity);
+            }
+            bool created = row == Table::NO_ROW;
+            if (created) row = table.create(&entity);
+            if (row == Table::NO_ROW) continue;   // full
+            write(row, received.extrapolated(lead), created);
+            kept.push_back(Replica{received.netId, entity});
+        }
+        while (old < replicas.size()) destroy(replicas[old++].entity);
+        replicas.swap(kept);
+    }
+
+    // No state this step: everything keeps moving as the host moves it
+    void deadReckon(Game& game) {
+        Position* position = game.enemies.column<Position>();
+        const Velocity* velocity = game.enemies.column<Velocity>();
+        for (uint32_t row = 0; row < game.enemies.size(); row++) position[row].value += velocity[row].value;
+        position = game.bullets.column<Position>();
+        for (uint32_t row = 0; row < game.bullets.size(); row++) position[row].value.y -= game.bulletSpeed;
+        position = game.powerUps.column<Position>();
+        for (uint32_t row = 0; row < game.powerUps.size(); row++) position[row].value.y += 2;
+    }
+
+    // Enemy projectiles are far too many to send. The client fires the boss
+    // patterns itself from the replicated boss on the host's pattern clock,
+    // and moves and tests them the same way; a hit only removes one here,
+    // the host decides what it costs.
+    void runProjectiles(Game& game) {
+        game.fireBossPattern();
+        game.moveProjectiles();
+        game.projectiles.removeMarked([](int, sf::Vector2f) {});
+    }
+
+    // One step of projectiles, kept on the shown tick: when displayTick
+    // jumps, the boss's clock gets ahead of or behind the host's there. While
+    // the boss is on station, projectiles ahead wait and ones behind catch up
+    // a step at a time, so they stay where the host has them.
+    void advanceProjectiles(Game& game) {
+        int32_t ahead = game.patternStep - shownPattern;
+        int32_t steps = 1;
+        if (game.bossOnStation() && ahead != 0) {
+            if (std::abs(ahead) > NET_HISTORY) {
+                game.patternStep = shownPattern;   // lost track; start over from here
+            } else if (ahead > 0) {
+                return;
+            } else {
+                steps -= ahead;
+            }
+        }
+        for (int32_t i = 0; i < steps; i++) runProjectiles(game);
+    }
+
+    // Moves the local rocket by this step's input. After a new state it
+    // starts from the host's position instead and replays every input the
+    // host hadn't used yet; a different result is a correction.
+    void predictRocket(Game& game, bool newState) {
+        Player& me = game.players[game.localPlayer];
+        bool canMove = !game.gameOver && !game.levelTransition;
+        sf::Vector2f predicted = canMove ? game.moveRocket(me.position, PlayerInput::fromBits(inputBits[seq % NET_HISTORY]))
+                                         : me.position;
+        if (!newState || seq - ackedSeq >= NET_HISTORY) {
+            if (newState) predicted = playerPosition(*newestState(), game.localPlayer);
+            me.position = predicted;
+            return;
+        }
+
+        sf::Vector2f replayed = playerPosition(*newestState(), game.localPlayer);
+        if (canMove) {
+            for (uint32_t s = ackedSeq + 1; s <= seq; s++) {
+                replayed = game.moveRocket(replayed, PlayerInput::fromBits(inputBits[s % NET_HISTORY]));
+            }
+        }
+        sf::Vector2f error = replayed - predicted;
+        if (std::abs(error.x) + std::abs(error.y) > 0.5f) corrections++;
+        me.position = replayed;
+    }
+
+    static sf::Vector2f position(const NetEntity& entity) {
+        return sf::Vector2f(entity.field[0], entity.field[1]) / static_cast<float>(NetEntity::POSITION_UNITS);
+    }
+
+    static sf::Vector2f velocity(const NetEntity& entity) {
+        return sf::Vector2f(entity.field[2], entity.field[3]) / static_cast<float>(NetEntity::VELOCITY_UNITS);
+    }
+
+    static sf::Vector2f playerPosition(const NetWorld& world, int player) {
+        return sf::Vector2f(world.scalars[SCALAR_PLAYER_X + 2 * player], world.scalars[SCALAR_PLAYER_X + 2 * player + 1]) /
+               static_cast<float>(NetEntity::POSITION_UNITS);
+    }
+
+    NetAddress host;
+    NetSocket socket;
+    State state = State::CONNECTING;
+    int64_t lastHelloUs = INT64_MIN / 2;
+    int64_t lastHeardUs = 0;
+    std::vector<uint8_t> packet;
+
+    uint32_t seq = 0;                       // of the newest input sent, from 1
+    uint32_t ackedSeq = 0;                  // newest input the host has used
+    uint8_t inputBits[NET_HISTORY] = {};
+    int64_t sentUs[NET_HISTORY] = {};
+
+    NetWorld history[NET_HISTORY];          // decoded states, baselines for the next ones
+    bool hasNewest = false;
+    uint32_t newestTick = 0;
+    uint32_t displayTick = 0;               // host tick being shown
+    int32_t shownPattern = 0;               // the host's boss pattern clock at displayTick
+    int32_t lastHostPattern = 0;            // the boss pattern clock in the newest state
+    std::vector<Replica> replicas[NetWorld::LISTS];
+    std::vector<Replica> kept;
+
+    uint64_t snapshots = 0;
+    uint64_t snapshotsLost = 0;
+    uint64_t snapshotsStale = 0;
+    uint64_t snapshotsBad = 0;
+    uint64_t snapshotBytes = 0;
+    uint64_t corrections = 0;
+    TimeHistogram roundTrip{500, 1000};
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Refers to one entity; goes stale as soon as that entity is destroyed,
+// even if its id is reused by a newer entity.
+struct Entity {
+    uint32_t id = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+// Entities that share one set of components (an archetype), stored as one
+// dense array per component.
+//
+// Rows [0, size()) are always live, so a system walks a few tightly packed
+// columns and never touches the components it doesn't use. Destroying a
+// row moves the last row into it: O(1) and the table stays dense, but row
+// order changes and a row index is only valid until the next destroy.
+// Entity handles follow their entity across such moves. All storage is
+// allocated up front, so creating and destroying never touch the heap.
+//
+// Component types must be distinct (columns are looked up by type).
+template <typename... Components>
+class EntityTable {
+public:
+    static constexpr uint32_t NO_ROW = UINT32_MAX;
+    static constexpr size_t ROW_SIZE = (sizeof(Components) + ... + 0);   // bytes per row in a snapshot
+
+    explicit EntityTable(size_t capacity)
+        : columns(std::vector<Components>(capacity)...),
+          rowToId(capacity), idToRow(capacity, NO_ROW), generations(capacity, 0) {
+        freeIds.reserve(capacity);
+        for (size_t i = capacity; i > 0; i--) {
+            freeIds.push_back(static_cast<uint32_t>(i - 1));
+        }
+    }
+
+    // Appends a row and returns it, or NO_ROW when the table is full.
+    // Its components hold whatever the last occupant left; set them all.
+    uint32_t create(Entity* handle = nullptr) {
+        if (freeIds.empty()) return NO_ROW;
+
+        uint32_t id = freeIds.back();
+        freeIds.pop_back();
+        uint32_t row = count++;
+        rowToId[row] = id;
+        idToRow[id] = row;
+
+        if (handle) *handle = Entity{id, generations[id]};
+        return row;
+    }
+
+    void destroy(uint32_t row) {
+        if (row >= count) return;
+
+        uint32_t id = rowToId[row];
+        uint32_t last = --count;
+        if (row != last) {
+            moveRow(last, row, std::index_sequence_for<Components...>());
+            rowToId[row] = rowToId[last];
+            idToRow[rowToId[row]] = row;
+        }
+        idToRow[id] = NO_ROW;
+        generations[id]++;
+        freeIds.push_back(id);
+    }
+
+    void destroy(Entity entity) {
+        uint32_t row = rowOf(entity);
+        if (row != NO_ROW) destroy(row);
+    }
+
+    // Current row of `entity`, or NO_ROW when the handle is stale
+    uint32_t rowOf(Entity entity) const {
+        if (entity.id >= idToRow.size() || generations[entity.id] != entity.generation) return NO_ROW;
+        return idToRow[entity.id];
+    }
+
+    bool isAlive(Entity entity) const { return rowOf(entity) != NO_ROW; }
+
+    Entity entityAt(uint32_t row) const { return Entity{rowToId[row], generations[rowToId[row]]}; }
+
+    // Dense array of one component, indexed by row
+    template <typename C>
+    C* column() { return std::get<std::vector<C>>(columns).data(); }
+
+    template <typename C>
+    const C* column() const { return std::get<std::vector<C>>(columns).data(); }
+
+    template <typename C>
+    C& get(uint32_t row) { return std::get<std::vector<C>>(columns)[row]; }
+
+    template <typename C>
+    const C& get(uint32_t row) const { return std::get<std::vector<C>>(columns)[row]; }
+
+    void clear() {
+        while (count > 0) destroy(count - 1);
+    }
+
+    // Snapshots: the live rows' components as raw bytes, column by column.
+    // Entity ids are not kept, so restoring makes every old handle stale;
+    // keep rows instead and look them up with entityAt() afterwards.
+    size_t rowBytes() const { return count * ROW_SIZE; }
+
+    // Writes rowBytes() bytes to `out` and returns the end
+    uint8_t* writeRows(uint8_t* out) const {
+        ((out = copyColumn(std::get<std::vector<Components>>(columns).data(), out)), ...);
+        return out;
+    }
+
+    // Replaces the contents with `rows` rows as written by writeRows().
+    // Returns false (and leaves the table empty) if they don't fit.
+    bool readRows(const uint8_t* in, uint32_t rows) {
+        if (rows > capacity()) {
+            clear();
+            return false;
+        }
+        // Rows that stay live keep their id under a new generation
+        uint32_t kept = std::min(count, rows);
+        for (uint32_t row = 0; row < kept; row++) {
+            generations[rowToId[row]]++;
+        }
+        for (uint32_t row = kept; row < count; row++) {
+            uint32_t id = rowToId[row];
+            idToRow[id] = NO_ROW;
+            generations[id]++;
+            freeIds.push_back(id);
+        }
+        for (uint32_t row = kept; row < rows; row++) {
+            uint32_t id = freeIds.back();
+            freeIds.pop_back();
+            rowToId[row] = id;
+            idToRow[id] = row;
+        }
+        count = rows;
+        ((in = fillColumn(std::get<std::vector<Components>>(columns).data(), in)), ...);
+        return true;
+    }
+
+    // Where column C starts in `rows` rows written by writeRows(), so a
+    // snapshot can be checked before anything is restored from it
+    template <typename C>
+    static const uint8_t* columnIn(const uint8_t* in, uint32_t rows) {
+        size_t before = 0;
+        bool found = false;
+        ((found = found || std::is_same_v<C, Components>, before += found ? 0 : sizeof(Components)), ...);
+        return in + before * rows;
+    }
+
+    uint32_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return rowToId.size(); }
+
+private:
+    template <typename C>
+    uint8_t* copyColumn(const C* column, uint8_t* out) const {
+        static_assert(std::is_trivially_copyable<C>::value, "snapshots copy components as bytes");
+        std::memcpy(out, column, count * sizeof(C));
+        return out + count * sizeof(C);
+    }
+
+    template <typename C>
+    const uint8_t* fillColumn(C* column, const uint8_t* in) {
+        std::memcpy(column, in, count * sizeof(C));
+        return in + count * sizeof(C);
+    }
+
+    template <size_t... I>
+    void moveRow(uint32_t from, uint32_t to, std::index_sequence<I...>) {
+        ((std::get<I>(columns)[to] = std::get<I>(columns)[from]), ...);
+    }
+
+    std::tuple<std::vector<Components>...> columns;
+    std::vector<uint32_t> rowToId;
+    std::vector<uint32_t> idToRow;       // NO_ROW for free ids
+    std::vector<uint32_t> generations;   // bumped when an id is freed
+    std::vector<uint32_t> freeIds;
+    uint32_t count = 0;
+};
@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "NetCodec.hpp"
+#include "SpscRing.hpp"
+
+enum class GameEventType : uint8_t {
+    RUN_START,       // startup or restart
+    KILL,            // detail: archetype, value: points scored
+    BOSS_DEFEATED,   // after its KILL; detail: archetype
+    COMBO_END,       // value: kills in the combo that just ran out
+    PICKUP,          // detail: PowerUpType
+    LIFE_LOST,       // detail: archetype that got through or fired, value: lives left
+    LEVEL_START,     // value: the new level, detail: its boss archetype + 1 (0 = none)
+    GAME_OVER,       // value: final score, detail: 1 if the run was won
+    STATE_LOADED,    // a snapshot was loaded (rewind, resume); steps continue from `step`
+    COUNT
+};
+
+const char* const GAME_EVENT_NAMES[static_cast<int>(GameEventType::COUNT)] = {
+    "run_start", "kill", "boss_defeated", "combo_end", "pickup", "life_lost", "level_start", "game_over", "state_loaded"};
+
+// One gameplay event, the same fixed 16 bytes for every type. `x`, `y` is
+// where it happened in whole pixels, when that means anything.
+struct GameEvent {
+    uint32_t step;
+    GameEventType type;
+    uint8_t level;
+    uint16_t detail;
+    int32_t value;
+    int16_t x, y;
+};
+
+static_assert(sizeof(GameEvent) == 16, "events are fixed 16-byte records");
+
+// Session log of gameplay events, written off the game thread.
+//
+// push() copies the record into a lock-free ring and returns: a few ns, no
+// lock, no syscall, no allocation. A writer thread drains the ring every
+// FLUSH_INTERVAL and appends it to the file as a block. If the ring ever
+// fills (the writer stalled for a long time) events are dropped and
+// counted rather than making the game wait.
+//
+// File: "NSEL" version, varint seed, varint start time (Unix seconds), then
+// blocks of varint event count, varint payload size, payload. Each event in
+// a payload is coded against the one before it in the same block:
+//   zigzag step delta, type byte, zigzag level delta, varint detail,
+//   zigzag value, zigzag x, zigzag y
+// which takes most events from 16 bytes to 6-9. Blocks stand alone, so a
+// log cut short by a crash reads back up to its last whole block.
+//
+// One thread pushes at a time (whichever runs the gameplay stage).
+class EventLog {
+public:
+    static constexpr uint8_t VERSION = 1;
+    static constexpr size_t RING_EVENTS = 4096;
+    static constexpr size_t BLOCK_EVENTS = 256;
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{100};
+
+    // Creates `path` and starts the writer; check ok()
+    EventLog(const std::string& path, uint32_t seed) : path(path), file(path, std::ios::binary) {
+        if (!file) return;
+        opened = true;
+        std::vector<uint8_t> header = {'N', 'S', 'E', 'L', VERSION};
+        ByteWriter out(header);
+        out.varint(seed);
+        out.varint(static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count())));
+        file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        bytesWritten = header.size();
+        thread = std::thread([this] { writeLoop(); });
+    }
+
+    ~EventLog() { close(); }
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    bool ok() const { return opened; }
+
+    void push(const GameEvent& event) {
+        if (!ring->push(event)) dropped++;
+        pushed++;
+    }
+
+    // Writes what is still queued and stops the writer. Call once nothing
+    // pushes any more; the destructor does it too.
+    void close() {
+        if (!thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    void report() {
+        close();
+        std::cout << "event log " << path << ": " << pushed - dropped << " events, " << bytesWritten << " bytes ("
+                  << (pushed > dropped ? static_cast<double>(bytesWritten) / (pushed - dropped) : 0.0) << " per event), "
+                  << dropped << " dropped" << (failed ? ", WRITE FAILED" : "") << "\n";
+    }
+
+private:
+    void writeLoop() {
+        GameEvent batch[BLOCK_EVENTS];
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            bool stop = stopping;   // one more drain after the last push
+            lock.unlock();
+            size_t count;
+            while ((count = ring->pop(batch, BLOCK_EVENTS)) > 0) writeBlock(batch, count);
+            file.flush();
+            failed |= !file;
+            lock.lock();
+            if (stop) return;
+            wake.wait_for(lock, FLUSH_INTERVAL, [this] { return stopping; });
+        }
+    }
+
+    void writeBlock(const GameEvent* events, size_t count) {
+        payload.clear();
+        ByteWriter out(payload);
+        GameEvent previous{};
+        for (size_t i = 0; i < count; i++) {
+            const GameEvent& event = events[i];
+            out.signedVarint(int64_t(event.step) - previous.step);
+            out.byte(static_cast<uint8_t>(event.type));
+            out.signedVarint(int64_t(event.level) - previous.level);
+            out.varint(event.detail);
+            out.signedVarint(event.value);
+            out.signedVarint(event.x);
+            out.signedVarint(event.y);
+            previous = event;
+        }
+
+        blockHeader.clear();
+        ByteWriter header(blockHeader);
+        header.varint(count);
+        header.varint(payload.size());
+        file.write(reinterpret_cast<const char*>(blockHeader.data()), static_cast<std::streamsize>(blockHeader.size()));
+        file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        bytesWritten += blockHeader.size() + payload.size();
+    }
+
+    std::string path;
+    std::ofstream file;
+    std::unique_ptr<SpscRing<GameEvent, RING_EVENTS>> ring = std::make_unique<SpscRing<GameEvent, RING_EVENTS>>();
+    uint64_t pushed = 0;    // game thread only
+    uint64_t dropped = 0;
+
+    // Writer thread only until close() joins it
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> blockHeader;
+    uint64_t bytesWritten = 0;
+    bool failed = false;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    bool opened = false;
+    std::thread thread;   // last, so everything it uses exists before it starts
+};
+
+// A whole log read back, for offline tools
+struct EventLogFile {
+    uint32_t seed = 0;
+    uint64_t startTime = 0;   // Unix seconds
+    std::vector<GameEvent> events;
+    bool truncated = false;   // ended inside a block, e.g. the game crashed
+
+    bool load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (bytes.size() < 5 || std::memcmp(bytes.data(), "NSEL", 4) != 0 || bytes[4] != EventLog::VERSION) return false;
+
+        ByteReader header(bytes.data() + 5, bytes.size() - 5);
+        seed = static_cast<uint32_t>(header.varint());
+        startTime = header.varint();
+        if (!header.ok()) return false;
+
+        events.clear();
+        truncated = false;
+        const uint8_t* pos = header.position();
+        const uint8_t* end = bytes.data() + bytes.size();
+        while (pos < end) {
+            ByteReader block(pos, static_cast<size_t>(end - pos));
+            uint64_t count = block.varint();
+            uint64_t size = block.varint();
+            const uint8_t* payload = block.position();
+            if (!block.ok() || count == 0 || size > static_cast<uint64_t>(end - payload)) {
+                truncated = true;
+                break;
+            }
+            if (!readBlock(payload, static_cast<size_t>(size), count)) return false;
+            pos = payload + size;
+        }
+        return true;
+    }
+
+private:
+    bool readBlock(const uint8_t* payload, size_t size, uint64_t count) {
+        ByteReader in(payload, size);
+        GameEvent previous{};
+        for (uint64_t i = 0; i < count; i++) {
+            GameEvent event{};
+            event.step = static_cast<uint32_t>(previous.step + in.signedVarint());
+            uint8_t type = in.byte();
+            event.type = static_cast<GameEventType>(type);
+            event.level = static_cast<uint8_t>(previous.level + in.signedVarint());
+            event.detail = static_cast<uint16_t>(in.varint());
+            event.value = static_cast<int32_t>(in.signedVarint());
+            event.x = static_cast<int16_t>(in.signedVarint());
+            event.y = static_cast<int16_t>(in.signedVarint());
+            if (!in.ok() || type >= static_cast<uint8_t>(GameEventType::COUNT)) return false;
+            events.push_back(event);
+            previous = event;
+        }
+        return in.atEnd();
+    }
+};
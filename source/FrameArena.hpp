@@ -0,0 +1,136 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for scratch data that only lives for one frame (one
+// simulation step here). allocate() bumps an offset into one block and
+// reset() takes everything back at once: no per-object frees, no heap
+// calls, and the memory is the same few cache lines every frame.
+//
+// A frame that needs more than the block holds spills to the heap, so
+// nothing breaks, and the next reset() grows the block to cover it. The
+// arena settles at the largest frame seen and after that never allocates.
+// One owner thread; nothing handed out survives reset().
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity) : block(allocateBlock(capacity)), blockSize(capacity) {}
+
+    ~FrameArena() {
+        freeSpills();
+        ::operator delete(block);
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // `alignment` must be a power of two no larger than the heap's own
+    void* allocate(size_t bytes, size_t alignment) {
+        size_t start = (offset + alignment - 1) & ~(alignment - 1);
+        if (start + bytes <= blockSize) {
+            offset = start + bytes;
+            return block + start;
+        }
+        return spill(bytes);
+    }
+
+    // Ends the frame: everything allocated since the last reset() is gone
+    void reset() {
+        size_t needed = offset + spilledBytes;
+        peak = std::max(peak, needed);
+        if (spills) {
+            freeSpills();
+            ::operator delete(block);
+            blockSize = std::max(needed, blockSize * 2);
+            block = allocateBlock(blockSize);
+        }
+        offset = 0;
+        spilledBytes = 0;
+    }
+
+    size_t used() const { return offset + spilledBytes; }
+    size_t capacity() const { return blockSize; }
+    size_t highWater() const { return std::max(peak, used()); }
+    size_t spillCount() const { return totalSpills; }   // heap fallbacks so far, each followed by a grow
+
+private:
+    struct Spill {
+        Spill* next;
+    };
+    static constexpr size_t SPILL_HEADER = alignof(std::max_align_t);
+
+    static std::byte* allocateBlock(size_t size) {
+        return static_cast<std::byte*>(::operator new(std::max<size_t>(size, 1)));
+    }
+
+    void* spill(size_t bytes) {
+        auto* header = static_cast<Spill*>(::operator new(SPILL_HEADER + bytes));
+        header->next = spills;
+        spills = header;
+        spilledBytes += bytes;
+        totalSpills++;
+        return reinterpret_cast<std::byte*>(header) + SPILL_HEADER;
+    }
+
+    void freeSpills() {
+        while (spills) {
+            Spill* next = spills->next;
+            ::operator delete(spills);
+            spills = next;
+        }
+    }
+
+    std::byte* block;
+    size_t blockSize;
+    size_t offset = 0;
+    Spill* spills = nullptr;
+    size_t spilledBytes = 0;
+    size_t totalSpills = 0;
+    size_t peak = 0;
+};
+
+// Standard allocator over a FrameArena. deallocate() does nothing; the
+// memory comes back at the next reset(), so a container using it must be
+// emptied or re-seated (see FrameVector) before it is used after one.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    explicit ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    friend bool operator==(const ArenaAllocator& a, const ArenaAllocator& b) { return a.arena == b.arena; }
+    friend bool operator!=(const ArenaAllocator& a, const ArenaAllocator& b) { return a.arena != b.arena; }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    FrameArena* arena;
+};
+
+// A vector whose storage lives in the arena for the current frame.
+// fresh() drops the old storage without touching it (it may already have
+// been handed out again), so call it at the start of every frame.
+template <typename T>
+class FrameVector : public std::vector<T, ArenaAllocator<T>> {
+public:
+    static_assert(std::is_trivially_destructible_v<T>, "frame storage is never destroyed element by element");
+
+    explicit FrameVector(FrameArena& arena) : std::vector<T, ArenaAllocator<T>>(ArenaAllocator<T>(arena)) {}
+
+    void fresh(size_t reserve = 0) {
+        std::vector<T, ArenaAllocator<T>> empty(this->get_allocator());
+        if (reserve) empty.reserve(reserve);
+        std::vector<T, ArenaAllocator<T>>::operator=(std::move(empty));
+    }
+};
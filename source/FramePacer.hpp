@@ -0,0 +1,100 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include "InputSource.hpp"
+#include "TimeHistogram.hpp"
+
+// Holds rendered frames to a steady period and hands the game a clean delta.
+//
+// A plain sleep (what setFramerateLimit does) can oversleep by a whole
+// scheduler tick, so frames came out anywhere from 16 to 30 ms apart. The
+// pacer sleeps until `spinMargin` before the deadline and spins the rest.
+// The margin follows the worst recent oversleep: small where the timer is
+// fine, larger where it is coarse, and the CPU only spins for that long.
+class FramePacer {
+public:
+    // `fps` of 0 runs frames back to back; deltas are clamped to `maxDelta` seconds
+    explicit FramePacer(float fps = 60.0f, float maxDelta = 0.25f)
+        : maxDeltaUs(static_cast<int64_t>(maxDelta * 1e6f)) {
+        setTarget(fps);
+    }
+
+    void setTarget(float fps) {
+        periodUs = fps > 0 ? static_cast<int64_t>(1e6f / fps) : 0;
+        deadline = 0;
+    }
+
+    // Blocks until the next frame is due and returns the seconds it stands
+    // for: real time, clamped, with timer jitter around the period removed
+    float waitForNextFrame() {
+        int64_t now = inputClockUs();
+        if (periodUs > 0 && deadline != 0) {
+            if (deadline - now > spinMarginUs) {
+                int64_t wake = deadline - spinMarginUs;
+                std::this_thread::sleep_for(std::chrono::microseconds(wake - now));
+                now = inputClockUs();
+                adaptMargin(now - wake);
+            }
+            while (now < deadline) {
+                std::this_thread::yield();
+                now = inputClockUs();
+            }
+        }
+        // Keep the cadence, but after missing a whole period start again from
+        // now rather than rushing frames out to catch up
+        deadline = (deadline != 0 && now - deadline < periodUs) ? deadline + periodUs : now + periodUs;
+
+        if (lastFrame == 0) {
+            lastFrame = now;
+            return 0.0f;
+        }
+        int64_t elapsed = now - lastFrame;
+        lastFrame = now;
+        frameTimes.add(elapsed);
+        return smooth(std::min(elapsed, maxDeltaUs)) / 1e6f;
+    }
+
+    // Time between consecutive frames, since startup
+    const TimeHistogram& histogram() const { return frameTimes; }
+
+    float targetMs() const { return periodUs / 1000.0f; }
+
+private:
+    static constexpr int64_t MIN_SPIN_US = 200;     // covers the wake-up itself
+    static constexpr int64_t START_SPIN_US = 2000;
+
+    // Jump up to a bad oversleep at once, drift back down slowly
+    void adaptMargin(int64_t late) {
+        int64_t wanted = std::max<int64_t>(late, 0) + MIN_SPIN_US;
+        if (wanted > spinMarginUs) {
+            spinMarginUs = wanted;
+        } else {
+            spinMarginUs -= (spinMarginUs - wanted) / 16;
+        }
+        spinMarginUs = std::min(spinMarginUs, periodUs);
+    }
+
+    // A frame within a few percent of the period counts as exactly one
+    // period and the difference is carried into later frames. The fixed-step
+    // accumulator then runs one step every frame at 60 Hz instead of
+    // alternating 0 and 2 when the timer wobbles around the step length;
+    // over time the deltas still add up to real time.
+    int64_t smooth(int64_t elapsed) {
+        carryUs += elapsed;
+        int64_t delta = carryUs;
+        if (periodUs > 0 && std::abs(carryUs - periodUs) < periodUs / 8) delta = periodUs;
+        carryUs -= delta;
+        return delta;
+    }
+
+    int64_t periodUs = 0;
+    int64_t maxDeltaUs;
+    int64_t spinMarginUs = START_SPIN_US;
+    int64_t deadline = 0;    // inputClockUs() the next frame is due
+    int64_t lastFrame = 0;
+    int64_t carryUs = 0;     // real time not yet handed out
+    TimeHistogram frameTimes{100, 1000};   // 0.1 ms buckets up to 100 ms
+};
@@ -0,0 +1,1994 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <SFML/System.hpp>
+#include <SFML/Window.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include "Rng.hpp"
+#include "Replay.hpp"
+#include "ParticleSystem.hpp"
+#include "ProjectileSystem.hpp"
+#include "FrameArena.hpp"
+#include "CollisionGrid.hpp"
+#include "SweptCollision.hpp"
+#include "EntityTable.hpp"
+#include "SpriteBatch.hpp"
+#include "Hud.hpp"
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+#include "WaveFile.hpp"
+#include "InputSource.hpp"
+#include "FramePacer.hpp"
+#include "Snapshot.hpp"
+#include "EventLog.hpp"
+#include "SoftwareCanvas.hpp"
+
+// Constants
+const float PI = 3.14159265f;
+const float SIM_DT = 1.0f / 60.0f;       // fixed simulation step; speeds are in pixels per step
+const int MAX_CATCHUP_STEPS = 5;         // cap on steps per frame so a hitch can't snowball
+const float MAX_FRAME_TIME = 0.25f;      // longest frame fed into the accumulator
+const size_t MAX_PARTICLES = 100000;
+const size_t MAX_BULLETS = 512;
+const size_t MAX_ENEMIES = 1024;
+const size_t MAX_POWERUPS = 64;
+const size_t MAX_PROJECTILES = 16384;   // enemy projectiles in flight at once
+const float GRID_CELL_SIZE = 64.0f;      // broad-phase cell, a bit larger than a normal enemy
+const size_t STEP_ARENA_BYTES = 256 * 1024;   // per-step collision scratch; grows if a step needs more
+const int TRAIL_LENGTH = 12;             // positions remembered per bullet trail
+const int MAX_PLAYERS = 2;               // co-op (--host / --join)
+const int REWIND_INTERVAL = 3;           // steps between rewind snapshots; rewinding runs this much faster
+const size_t REWIND_SNAPSHOTS = 200;     // 10 s of rewind
+const int AUTOSAVE_STEPS = 300;          // 5 s between background saves (--autosave)
+const float PLAYER_HITBOX_RADIUS = 5.0f; // enemy projectiles only hit the rocket's core...
+const sf::Vector2f PLAYER_CORE(25.0f, 28.0f);   // ...here, from the rocket's top-left
+const float BOSS_STATION_Y = 60.0f;      // a boss stops descending here and opens fire
+const float BOSS_SWAY_SPEED = 1.2f;      // then drifts side to side, pixels per step
+const float PATTERN_GRACE = 2.0f;        // seconds a boss holds fire after hitting a player
+
+// Power-up types
+enum class PowerUpType {
+    RAPID_FIRE,
+    SHIELD,
+    TRIPLE_SHOT
+};
+
+// Boss attack patterns, run one after another in a loop while a boss holds
+// its station. Below half health every pattern fires twice as often.
+enum class PatternKind {
+    SPIRAL,      // `count` arms turning by `spread` per volley
+    AIMED_FAN,   // `count` projectiles over a `spread` arc, centred on the nearest player
+    RING         // `count` projectiles all round, turned by `spread` per volley
+};
+
+struct BossPattern {
+    PatternKind kind;
+    int steps;        // how long it runs
+    int interval;     // steps between volleys
+    int count;
+    float speed;      // pixels per step
+    float spread;     // radians
+    int style;        // index in PROJECTILE_RADII and the atlas
+};
+
+const BossPattern BOSS_PATTERNS[] = {
+    {PatternKind::SPIRAL, 150, 4, 3, 3.0f, 0.23f, 0},
+    {PatternKind::AIMED_FAN, 120, 30, 7, 4.0f, 0.9f, 1},
+    {PatternKind::RING, 120, 40, 24, 2.5f, 0.13f, 2},
+    {PatternKind::SPIRAL, 150, 3, 5, 2.5f, -0.17f, 0},
+};
+const int BOSS_PATTERN_COUNT = sizeof(BOSS_PATTERNS) / sizeof(BOSS_PATTERNS[0]);
+const int PROJECTILE_STYLES = 3;
+const float PROJECTILE_RADII[PROJECTILE_STYLES] = {4.0f, 5.0f, 6.0f};
+
+// Simulation components. Entities hold no render state: sizes, colours
+// and health bars are derived from these and the archetype when drawing.
+struct Position { sf::Vector2f value; };
+struct Velocity { sf::Vector2f value; };          // pixels per step
+struct Health { int current; int max; };
+struct EnemyKind { int archetype; };              // index in the wave file
+struct BulletKind { bool tripleShot; };
+struct PowerUpKind { PowerUpType type; float age; };   // age drives the pulse
+
+// Cosmetic: the bullet's last TRAIL_LENGTH positions, newest at head - 1
+struct Trail {
+    sf::Vector2f points[TRAIL_LENGTH];
+    int head;
+    int count;
+    
+    void push(sf::Vector2f point) {
+        points[head] = point;
+        head = (head + 1) % TRAIL_LENGTH;
+        count = std::min(count + 1, TRAIL_LENGTH);
+    }
+};
+
+// One rocket. Co-op players share lives, score and power-ups.
+struct Player {
+    sf::Vector2f position;
+    sf::Vector2f prevPosition;   // at the start of the step, for interpolation
+    float shootCooldown = 0.0f;
+    PlayerInput input;
+};
+
+static_assert(sizeof(SnapshotState::rocketPositions) / sizeof(sf::Vector2f) == MAX_PLAYERS, "snapshots hold every player");
+static_assert(MAX_PLAYERS <= ProjectileSystem::MAX_TARGETS, "every player is a projectile target");
+
+using EnemyTable = EntityTable<Position, Velocity, Health, EnemyKind>;
+using BulletTable = EntityTable<Position, BulletKind, Trail>;
+using PowerUpTable = EntityTable<Position, PowerUpKind>;
+
+class Game;
+
+// Co-op networking (Coop.hpp) takes over each simulation step: the host
+// runs the step with the remote player's input, a client copies the host's
+// state instead of simulating it.
+class NetSession {
+public:
+    virtual ~NetSession() = default;
+    virtual void step(Game& game) = 0;
+    virtual void report() const {}   // printed when the game loop ends
+};
+
+
+class Game {
+    friend class GameBench;   // bench.cpp drives stages and scenario state directly
+    friend class Autopilot;   // reads entity tables to pick targets
+    friend class CoopHost;    // captures the state it sends
+    friend class CoopClient;  // writes the state it receives into the tables
+    
+private:
+    const unsigned int width = 1000;
+    const unsigned int height = 800;
+    bool headless = false;                       // no window, font or draw calls
+    std::unique_ptr<sf::RenderWindow> window;
+    std::unique_ptr<SoftwareCanvas> canvas;      // headless frames drawn on the CPU (--software)
+    TimeHistogram renderTimes{50, 400};          // of those frames, 50 us buckets
+    
+    // Players - rocket ships
+    sf::ConvexShape rocketShape;                // drawn and measured at the origin
+    sf::FloatRect rocketBox;
+    Player players[MAX_PLAYERS];
+    int playerCount = 1;
+    int localPlayer = 0;                        // the one inputSource steers
+    std::unique_ptr<InputSource> inputSource;   // keyboard with a window, none headless
+    int64_t lastPollUs = 0;                     // inputClockUs() of the last event poll
+    float playerSpeed = 8.0f;
+    sf::CircleShape shield;
+    bool hasShield = false;
+    float shieldTimer = 0.0f;
+    
+    // Triple shot power-up
+    bool hasTripleShot = false;
+    float tripleShotTimer = 0.0f;
+    
+    // Bullets
+    BulletTable bullets{MAX_BULLETS};
+    float bulletSpeed = 12.0f;
+    float fireRate = 0.15f;
+    bool rapidFire = false;
+    float rapidFireTimer = 0.0f;
+    
+    // Enemies
+    EnemyTable enemies;
+    Entity bossEntity;
+    float baseEnemySpeed = 2.0f;
+    float spawnTimer = 0.0f;
+    float spawnInterval = 1.2f;
+    
+    // Power-ups
+    PowerUpTable powerUps{MAX_POWERUPS};
+    float powerUpSpawnTimer = 0.0f;
+    
+    // Enemy projectiles and the boss pattern that fires them
+    ProjectileSystem projectiles{MAX_PROJECTILES};
+    int patternStep = 0;            // steps since the boss took its station; picks pattern and volley
+    float patternCooldown = 0.0f;   // the boss holds fire while > 0
+    
+    // Collision broad phase, rebuilt every step in memory from the step arena
+    FrameArena stepArena{STEP_ARENA_BYTES};   // reset at the start of updateGameplay()
+    CollisionGrid enemyGrid{static_cast<float>(width), static_cast<float>(height), GRID_CELL_SIZE, stepArena};
+    CollisionGrid powerUpGrid{static_cast<float>(width), static_cast<float>(height), GRID_CELL_SIZE, stepArena};
+    SweptTargets sweptEnemies{stepArena};     // narrow phase for bullets, same indices as enemyGrid
+    
+    // Local bounds of each styled shape, outline included, measured once
+    sf::FloatRect bulletBox;
+    sf::FloatRect powerUpBox;                 // around the centre, unscaled
+    std::vector<sf::FloatRect> enemyBoxes;    // by archetype
+    
+    // Particles
+    ParticleSystem particles{MAX_PARTICLES};
+    sf::VertexArray particleVertices;
+    sf::VertexArray projectileVertices;
+    
+    // Sprite atlas and per-layer batches (only built when something draws)
+    SpriteAtlas atlas;
+    AtlasRegion bulletRegions[2];     // normal, triple shot
+    std::vector<AtlasRegion> enemyRegions;   // by archetype
+    AtlasRegion powerUpRegions[3];    // by PowerUpType
+    AtlasRegion flameRegions[2];
+    AtlasRegion rocketRegions[MAX_PLAYERS];
+    AtlasRegion shieldRegion;
+    ProjectileSystem::Sprite projectileSprites[PROJECTILE_STYLES];
+    AtlasRegion dotRegion;            // stars
+    AtlasRegion glowRegion;           // particles
+    AtlasRegion solidRegion;          // health bars and trails
+    SpriteBatch backgroundBatch;      // stars and trails
+    SpriteBatch spriteBatch;          // power-ups, player, bullets, enemies
+    
+    // Level system (levels and enemy archetypes come from the wave file)
+    WaveFile waves;
+    int currentLevel = 1;
+    int enemiesKilledInLevel = 0;
+    int enemiesNeededForNextLevel = 15;
+    bool levelTransition = false;
+    float levelTransitionTimer = 0.0f;
+    
+    // UI
+    int score = 0;
+    int lives = 3;
+    int combo = 0;
+    float comboTimer = 0.0f;
+    BitmapFont font;
+    std::shared_ptr<HudCounter> scoreText;
+    std::shared_ptr<HudCounter> livesText;
+    std::shared_ptr<HudCounter> levelText;
+    std::shared_ptr<HudCounter> comboText;
+    std::shared_ptr<HudCounter> levelUpText;
+    std::shared_ptr<HudCounter> finalScoreText;
+    std::shared_ptr<HudCounter> levelReachedText;
+    BitmapText frameTimesText{font, "", 11};   // the F4 line, rewritten in place every frame
+    HudPanel powerUpPanels[3];      // indicator per PowerUpType
+    HudPanel transitionPanel;       // overlay + "GET READY!"
+    HudPanel gameOverPanel;         // overlay + "GAME OVER" + restart hint
+    bool fontLoaded = false;        // HUD built (with a window or a software canvas)
+    
+    // Stars background
+    std::vector<sf::CircleShape> stars;
+    std::vector<float> starSpeeds;
+    
+    // Screen shake
+    float screenShake = 0.0f;
+    sf::Vector2f shakeOffset;
+    
+    // Game state
+    bool gameOver = false;
+    FramePacer pacer{60.0f, MAX_FRAME_TIME};
+    float accumulator = 0.0f;
+    float renderAlpha = 1.0f;   // fraction of a step between the last two sim states
+    bool showProfiler = false;  // F3, only in builds with PROFILER_ENABLED
+    bool showFrameTimes = false;  // F4
+    uint64_t stepCount = 0;     // steps since startup, across restarts
+    std::unique_ptr<EventLog> eventLog;   // --event-log, null without
+    
+    // Save states: F5/F9 quick save and load, hold Backspace to rewind,
+    // --autosave writes one to disk in the background for crash-resume
+    Snapshot quickSave;
+    uint64_t recordingCutTo = 0;   // fewest steps --record was cut back to since the quick save
+    std::vector<Snapshot> rewindBuffer{REWIND_SNAPSHOTS};   // ring, buffers reused
+    size_t rewindNewest = 0;
+    size_t rewindCount = 0;
+    bool rewinding = false;
+    std::unique_ptr<SnapshotWriter> autosave;
+    Snapshot autosaveSnapshot;
+    
+    // Co-op (--host / --join); save states are off while it runs
+    std::unique_ptr<NetSession> session;
+    
+    // Random streams, one per subsystem, all derived from a single seed
+    uint32_t seed;
+    Rng spawnRng;   // enemy types and positions
+    Rng lootRng;    // power-up drops
+    Rng starRng;    // starfield layout
+    Rng fxRng;      // particles, screen shake
+    
+    // Input recording (--record)
+    bool recording = false;
+    Replay replay;
+    
+    // Update stages run as a task graph on the worker threads (--threads)
+    JobSystem jobs;
+    TaskGraph updateStages;
+    float stageDelta = 0.0f;   // deltaTime of the step being run by updateStages
+    
+    // Colors
+    sf::Color neonCyan = sf::Color(0, 255, 255);
+    sf::Color neonPink = sf::Color(255, 0, 255);
+    sf::Color neonGreen = sf::Color(0, 255, 100);
+    sf::Color neonOrange = sf::Color(255, 150, 0);
+    sf::Color neonYellow = sf::Color(255, 255, 0);
+    
+public:
+    // `levelsPath` names a compiled wave file; empty means the built-in levels
+    explicit Game(bool headlessMode = false, uint32_t seedValue = 0, unsigned workerThreads = 0,
+                  size_t enemyCapacity = MAX_ENEMIES, const std::string& levelsPath = "")
+        : headless(headlessMode), enemies(enemyCapacity), seed(seedValue), jobs(workerThreads) {
+        std::string error;
+        if (!levelsPath.empty() && !waves.open(levelsPath, &error)) {
+            std::cerr << "could not load levels " << levelsPath << ": " << error << " (using built-in levels)\n";
+        }
+        if (!headless) {
+            window = std::make_unique<sf::RenderWindow>(sf::VideoMode({width, height}), "NEON SPACE ASSAULT - LEVEL MODE", sf::Style::Close);
+            window->setKeyRepeatEnabled(false);
+            inputSource = std::make_unique<KeyboardInput>();
+        }
+        initializeGame();
+        buildUpdateStages();
+    }
+    
+    // Gameplay runs first and alone: it reads and writes nearly everything
+    // and draws from spawnRng/lootRng/fxRng in a fixed order. The cosmetic
+    // stages after it own disjoint data and run side by side.
+    void buildUpdateStages() {
+        int gameplay = updateStages.add([this] { updateGameplay(stageDelta); });
+        updateStages.add([this] { updateParticles(stageDelta); }, {gameplay});
+        updateStages.add([this] { updateTrails(); }, {gameplay});
+        updateStages.add([this] { updateStars(); }, {gameplay});
+    }
+
+    void spawnBoss(int type) {
+        const EnemyArchetype& archetype = waves.archetype(type);
+        addEnemy(type, sf::Vector2f(width / 2.f - archetype.width / 2.f, archetype.spawnY), &bossEntity);
+        patternStep = 0;
+    }
+    
+    // Fills in every component of a new enemy
+    void addEnemy(int type, sf::Vector2f position, Entity* handle = nullptr) {
+        uint32_t row = enemies.create(handle);
+        if (row == EnemyTable::NO_ROW) return;
+        const EnemyArchetype& archetype = waves.archetype(type);
+        int maxHealth = archetype.health + archetype.healthPerLevel * currentLevel;
+        enemies.get<Position>(row).value = position;
+        enemies.get<Velocity>(row).value = sf::Vector2f(0.f, enemySpeed(type));
+        enemies.get<Health>(row) = Health{maxHealth, maxHealth};
+        enemies.get<EnemyKind>(row).archetype = type;
+    }
+    
+    // Look of each entity kind, shared by spawning and the sprite atlas
+    void styleBullet(sf::CircleShape& bullet, sf::Color color) const {
+        bullet.setRadius(4);
+        bullet.setFillColor(color);
+        bullet.setOutlineThickness(2);
+        bullet.setOutlineColor(sf::Color::White);
+    }
+    
+    void styleEnemy(sf::RectangleShape& shape, int type) const {
+        const EnemyArchetype& archetype = waves.archetype(type);
+        shape.setSize(sf::Vector2f(archetype.width, archetype.height));
+        shape.setFillColor(sf::Color(archetype.color[0], archetype.color[1], archetype.color[2], archetype.color[3]));
+        shape.setOutlineThickness(archetype.outline);
+        shape.setOutlineColor(sf::Color::White);
+    }
+    
+    void styleProjectile(sf::CircleShape& shape, int style) const {
+        const sf::Color colors[PROJECTILE_STYLES] = {neonPink, neonOrange, sf::Color(180, 50, 255)};
+        shape.setRadius(PROJECTILE_RADII[style]);
+        shape.setFillColor(colors[style]);
+        shape.setOutlineThickness(1.5f);
+        shape.setOutlineColor(sf::Color::White);
+    }
+    
+    void stylePowerUp(sf::CircleShape& shape, PowerUpType type) const {
+        shape.setRadius(15);
+        shape.setOrigin(sf::Vector2f(15.f, 15.f));
+        
+        switch (type) {
+            case PowerUpType::RAPID_FIRE:
+                shape.setFillColor(sf::Color(255, 100, 0, 200));
+                break;
+            case PowerUpType::SHIELD:
+                shape.setFillColor(sf::Color(0, 200, 255, 200));
+                break;
+            case PowerUpType::TRIPLE_SHOT:
+                shape.setFillColor(sf::Color(255, 255, 0, 200));
+                break;
+        }
+        
+        shape.setOutlineThickness(2);
+        shape.setOutlineColor(sf::Color::White);
+    }
+    
+    // Collision boxes come from the styled shapes, so they match what is drawn
+    void measureShapes() {
+        rocketBox = rocketShape.getLocalBounds();
+        
+        sf::CircleShape bullet;
+        styleBullet(bullet, neonCyan);
+        bulletBox = bullet.getLocalBounds();
+        
+        sf::CircleShape powerUp;
+        stylePowerUp(powerUp, PowerUpType::RAPID_FIRE);
+        powerUpBox = powerUp.getLocalBounds();
+        powerUpBox.position -= powerUp.getOrigin();
+        
+        enemyBoxes.clear();
+        for (int type = 0; type < waves.archetypeCount(); type++) {
+            sf::RectangleShape enemy;
+            styleEnemy(enemy, type);
+            enemyBoxes.push_back(enemy.getLocalBounds());
+        }
+    }
+    
+    sf::FloatRect enemyBounds(uint32_t row) const {
+        sf::FloatRect box = enemyBoxes[enemies.get<EnemyKind>(row).archetype];
+        box.position += enemies.get<Position>(row).value;
+        return box;
+    }
+    
+    sf::FloatRect bulletBounds(uint32_t row) const {
+        sf::FloatRect box = bulletBox;
+        box.position += bullets.get<Position>(row).value;
+        return box;
+    }
+    
+    // Power-ups are centred on their position and pulse in size
+    float powerUpScale(uint32_t row) const {
+        return 1.0f + sin(powerUps.get<PowerUpKind>(row).age * 10) * 0.2f;
+    }
+    
+    sf::FloatRect powerUpBounds(uint32_t row) const {
+        float scale = powerUpScale(row);
+        return sf::FloatRect(powerUps.get<Position>(row).value + powerUpBox.position * scale, powerUpBox.size * scale);
+    }
+    
+    // Rasterises every sprite the renderer uses into one atlas
+    void buildAtlas() {
+        atlas.create(sf::Vector2u(512, 256));
+        
+        sf::CircleShape bullet;
+        styleBullet(bullet, neonCyan);
+        bulletRegions[0] = atlas.bake(bullet);
+        styleBullet(bullet, neonYellow);
+        bulletRegions[1] = atlas.bake(bullet);
+        
+        enemyRegions.clear();
+        for (int type = 0; type < waves.archetypeCount(); type++) {
+            sf::RectangleShape enemy;
+            styleEnemy(enemy, type);
+            enemyRegions.push_back(atlas.bake(enemy));
+        }
+        
+        for (int type = 0; type < 3; type++) {
+            sf::CircleShape powerUp;
+            stylePowerUp(powerUp, static_cast<PowerUpType>(type));
+            powerUpRegions[type] = atlas.bake(powerUp);
+        }
+        
+        sf::CircleShape flame1(6);
+        flame1.setFillColor(sf::Color(255, 150, 0, 180));
+        flameRegions[0] = atlas.bake(flame1);
+        
+        sf::CircleShape flame2(4);
+        flame2.setFillColor(sf::Color(255, 50, 0, 200));
+        flameRegions[1] = atlas.bake(flame2);
+        
+        // Player 2 in pink
+        const sf::Color rocketColors[MAX_PLAYERS] = {neonCyan, neonPink};
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            rocketShape.setFillColor(rocketColors[p]);
+            rocketRegions[p] = atlas.bake(rocketShape);
+        }
+        shieldRegion = atlas.bake(shield);
+        
+        // Projectiles are drawn around their centre
+        for (int style = 0; style < PROJECTILE_STYLES; style++) {
+            sf::CircleShape projectile;
+            styleProjectile(projectile, style);
+            AtlasRegion region = atlas.bake(projectile);
+            float radius = PROJECTILE_RADII[style];
+            projectileSprites[style] = ProjectileSystem::Sprite{region.texRect, -region.origin - sf::Vector2f(radius, radius)};
+        }
+        
+        sf::CircleShape dot(8);
+        dotRegion = atlas.bake(dot);
+        glowRegion = atlas.bakeGlowDot(8);
+        solidRegion = atlas.bakeSolid();
+        
+        if (window) atlas.upload();
+    }
+    
+    // Creates the HUD widgets and pre-composites the static panels
+    void buildHud() {
+        scoreText = std::make_shared<HudCounter>(font, 28, neonCyan, [](int value, std::u32string& out) {
+            appendFormatted(out, "SCORE: %08d", value);
+        });
+        scoreText->setPosition(sf::Vector2f(20, 20));
+        
+        livesText = std::make_shared<HudCounter>(font, 28, neonPink, [](int value, std::u32string& out) {
+            appendFormatted(out, "LIVES: ");
+            out.append(std::max(value, 0), U'\u2665');
+        });
+        livesText->setPosition(sf::Vector2f(20, 60));
+        
+        levelText = std::make_shared<HudCounter>(font, 28, neonGreen, [](int value, std::u32string& out) {
+            appendFormatted(out, "LEVEL: %d", value);
+        });
+        levelText->setPosition(sf::Vector2f(width - 200.0f, 20));
+        
+        comboText = std::make_shared<HudCounter>(font, 40, neonOrange, [](int value, std::u32string& out) {
+            appendFormatted(out, "COMBO x%d", value);
+        });
+        comboText->setPosition(sf::Vector2f(width / 2.0f - 100, 100));
+        
+        levelUpText = std::make_shared<HudCounter>(font, 60, neonYellow, [](int value, std::u32string& out) {
+            appendFormatted(out, "LEVEL %d", value);
+        });
+        levelUpText->centerOn(width / 2.0f, height / 2.0f - 50);
+        
+        finalScoreText = std::make_shared<HudCounter>(font, 30, neonCyan, [](int value, std::u32string& out) {
+            appendFormatted(out, "FINAL SCORE: %d", value);
+        }, false);
+        finalScoreText->centerOn(width / 2.0f, height / 2.0f + 80);
+        
+        levelReachedText = std::make_shared<HudCounter>(font, 25, neonGreen, [](int value, std::u32string& out) {
+            appendFormatted(out, "Level Reached: %d", value);
+        }, false);
+        levelReachedText->centerOn(width / 2.0f, height / 2.0f + 130);
+        
+        frameTimesText.setFillColor(neonGreen);
+        frameTimesText.setPosition(sf::Vector2f(10, height - 24.0f));
+        
+        composeIndicator(powerUpPanels[static_cast<int>(PowerUpType::RAPID_FIRE)], "RAPID FIRE", sf::Color(255, 100, 0));
+        composeIndicator(powerUpPanels[static_cast<int>(PowerUpType::SHIELD)], "SHIELD ACTIVE", sf::Color(0, 200, 255));
+        composeIndicator(powerUpPanels[static_cast<int>(PowerUpType::TRIPLE_SHOT)], "TRIPLE SHOT", sf::Color(255, 255, 0));
+        
+        sf::Vector2u screen(width, height);
+        transitionPanel.compose(screen, [this](SoftwareCanvas& target) {
+            drawOverlay(target, 200);
+            centeredText("GET READY!", 40, sf::Color::White, height / 2.0f + 50, false).draw(target);
+        }, window != nullptr);
+        
+        gameOverPanel.compose(screen, [this](SoftwareCanvas& target) {
+            drawOverlay(target, 180);
+            centeredText("GAME OVER", 70, neonPink, height / 2.0f - 100, true).draw(target);
+            centeredText("Press R to Restart", 35, sf::Color::White, height / 2.0f, false).draw(target);
+        }, window != nullptr);
+    }
+    
+    void composeIndicator(HudPanel& panel, const char* label, sf::Color color) {
+        panel.compose(sf::Vector2u(154, 34), [&](SoftwareCanvas& target) {
+            sf::RectangleShape indicator(sf::Vector2f(150, 30));
+            indicator.setPosition(sf::Vector2f(2, 2));
+            indicator.setFillColor(sf::Color(color.r, color.g, color.b, 100));
+            indicator.setOutlineThickness(2);
+            indicator.setOutlineColor(color);
+            target.drawShape(indicator, sf::Vector2f(0, 0), SoftwareCanvas::Blend::None);
+            
+            BitmapText text(font, label, 18);
+            text.setFillColor(sf::Color::White);
+            text.setPosition(sf::Vector2f(std::round(77 - text.getLocalBounds().size.x / 2), 10));
+            text.draw(target);
+        }, window != nullptr);
+    }
+    
+    void drawOverlay(SoftwareCanvas& target, uint8_t alpha) const {
+        sf::RectangleShape overlay(sf::Vector2f(static_cast<float>(width), static_cast<float>(height)));
+        overlay.setFillColor(sf::Color(0, 0, 0, alpha));
+        target.drawShape(overlay, sf::Vector2f(0, 0), SoftwareCanvas::Blend::None);
+    }
+    
+    BitmapText centeredText(const char* string, unsigned int size, sf::Color color, float y, bool bold) const {
+        BitmapText text(font);
+        text.setCharacterSize(size);
+        text.setFillColor(color);
+        if (bold) text.setStyle(sf::Text::Bold);
+        text.setString(string);
+        sf::FloatRect bounds = text.getLocalBounds();
+        text.setPosition(sf::Vector2f(width / 2.0f - bounds.size.x / 2, y));
+        return text;
+    }
+    
+    void initializeGame() {
+        spawnRng.seed(seed, 1);
+        lootRng.seed(seed, 2);
+        starRng.seed(seed, 3);
+        fxRng.seed(seed, 4);
+        applyLevel(currentLevel);
+        
+        // Create rocket ship (more detailed)
+        rocketShape.setPointCount(7);
+        rocketShape.setPoint(0, sf::Vector2f(25, 0));     // Nose
+        rocketShape.setPoint(1, sf::Vector2f(15, 25));    // Left body
+        rocketShape.setPoint(2, sf::Vector2f(10, 25));    // Left inner
+        rocketShape.setPoint(3, sf::Vector2f(0, 50));     // Left fin
+        rocketShape.setPoint(4, sf::Vector2f(25, 35));    // Bottom center
+        rocketShape.setPoint(5, sf::Vector2f(50, 50));    // Right fin
+        rocketShape.setPoint(6, sf::Vector2f(40, 25));    // Right inner
+        
+        // Create gradient effect with multiple colors
+        rocketShape.setFillColor(neonCyan);
+        rocketShape.setOutlineThickness(2);
+        rocketShape.setOutlineColor(sf::Color::White);
+        placePlayers();
+        
+        // Shield
+        shield.setRadius(45);
+        shield.setFillColor(sf::Color(0, 200, 255, 50));
+        shield.setOutlineThickness(3);
+        shield.setOutlineColor(sf::Color(0, 200, 255, 150));
+        shield.setOrigin(sf::Vector2f(45.f, 45.f));
+        
+        measureShapes();
+        if (!headless) {
+            buildAtlas();
+        }
+        
+        // Upload the built-in font (headless runs have nothing to draw text on)
+        if (!headless && font.load()) {
+            fontLoaded = true;
+            buildHud();
+        }
+        
+        // Create parallax starfield
+        for (int i = 0; i < 200; i++) {
+            float size = static_cast<float>(starRng.nextInt(3) + 1);
+            sf::CircleShape star(size);
+            uint8_t brightness = static_cast<uint8_t>(starRng.nextInt(200) + 55);
+            star.setFillColor(sf::Color(brightness, brightness, 255, static_cast<uint8_t>(starRng.nextInt(150) + 100)));
+            star.setPosition(sf::Vector2f(static_cast<float>(starRng.nextInt(width)), static_cast<float>(starRng.nextInt(height))));
+            stars.push_back(star);
+            starSpeeds.push_back(size * 0.5f);
+        }
+    }
+    
+    // Drains window events. Key changes go to the input source stamped with
+    // the midpoint of the interval since the last poll (SFML events carry no
+    // time of their own), so the latency stat is an estimate that can be off
+    // by up to half a frame; the steps that follow sample it.
+    void handleInput() {
+        PROFILE_ZONE("input");
+        int64_t now = inputClockUs();
+        int64_t stamp = lastPollUs ? (lastPollUs + now) / 2 : now;
+        lastPollUs = now;
+        
+        while (const std::optional event = window->pollEvent()) {
+            if (event->is<sf::Event::Closed>()) {
+                window->close();
+            }
+            if (event->is<sf::Event::FocusLost>()) {
+                if (inputSource) inputSource->releaseAll();
+                rewinding = false;
+            }
+            
+            if (const auto* keyPressed = event->getIf<sf::Event::KeyPressed>()) {
+                if (keyPressed->code == sf::Keyboard::Key::R && gameOver) {
+                    players[localPlayer].input.restart = true;
+                }
+                if (keyPressed->code == sf::Keyboard::Key::F3) {
+                    showProfiler = !showProfiler;
+                }
+                if (keyPressed->code == sf::Keyboard::Key::F4) {
+                    showFrameTimes = !showFrameTimes;
+                }
+                if (keyPressed->code == sf::Keyboard::Key::F5 && !session) {
+                    saveSnapshot(quickSave);
+                    recordingCutTo = stepCount;
+                }
+                if (keyPressed->code == sf::Keyboard::Key::F9 && !quickSave.empty() && !session) {
+                    if (quickSaveOnRecording()) {
+                        loadSnapshot(quickSave);
+                        rewindCount = 0;
+                    } else {
+                        std::cerr << "the quick save is not on the recorded timeline any more, --record can't follow it\n";
+                    }
+                }
+                if (keyPressed->code == sf::Keyboard::Key::Backspace && !session) {
+                    rewinding = true;
+                }
+                if (inputSource) inputSource->keyEvent(keyPressed->code, true, stamp);
+            }
+            if (const auto* keyReleased = event->getIf<sf::Event::KeyReleased>()) {
+                if (keyReleased->code == sf::Keyboard::Key::Backspace) {
+                    rewinding = false;
+                }
+                if (inputSource) inputSource->keyEvent(keyReleased->code, false, stamp);
+            }
+        }
+    }
+    
+    // Frames per second the window is paced to; 0 means as fast as possible
+    void setFrameRate(float fps) { pacer.setTarget(fps); }
+    
+    // Replaces the keyboard, e.g. with the Autopilot
+    void setInputSource(std::unique_ptr<InputSource> source) {
+        inputSource = std::move(source);
+    }
+    
+    // Hosts or joins a co-op game from the next step on
+    void setSession(std::unique_ptr<NetSession> netSession) {
+        session = std::move(netSession);
+    }
+    
+    // Logs gameplay events to `path` from here on (see EventLog)
+    bool startEventLog(const std::string& path) {
+        eventLog = std::make_unique<EventLog>(path, seed);
+        if (!eventLog->ok()) {
+            eventLog.reset();
+            return false;
+        }
+        logEvent(GameEventType::RUN_START);
+        return true;
+    }
+    
+    // Makes a headless run draw every step into a canvas the size of the
+    // window (--software), for screenshots and render timing without a GPU
+    void enableSoftwareRender() {
+        if (window) return;
+        canvas = std::make_unique<SoftwareCanvas>(width, height);
+        buildAtlas();
+        fontLoaded = font.load(false);
+        if (fontLoaded) buildHud();
+    }
+    
+    // The last software frame, null without --software
+    const SoftwareCanvas* softwareFrame() const { return canvas.get(); }
+    
+    // Enemy projectiles in flight, e.g. to check a co-op client's against the host's
+    const ProjectileSystem& enemyProjectiles() const { return projectiles; }
+    
+    // A boss is on station and its patterns are running
+    bool bossOnStation() const {
+        uint32_t row = enemies.rowOf(bossEntity);
+        return !gameOver && !levelTransition && row != EnemyTable::NO_ROW &&
+               enemies.get<Position>(row).value.y >= BOSS_STATION_Y;
+    }
+    
+    // Applies the sampled input for one simulation step
+    void applyInput() {
+        bool restart = false;
+        for (int p = 0; p < playerCount; p++) {
+            restart |= players[p].input.restart;
+            players[p].input.restart = false;
+        }
+        if (restart && gameOver) {
+            resetGame();
+        }
+        
+        if (gameOver || levelTransition) return;
+        
+        for (int p = 0; p < playerCount; p++) {
+            Player& player = players[p];
+            player.position = moveRocket(player.position, player.input);
+            
+            // Shooting
+            if (player.input.fire && player.shootCooldown <= 0) {
+                shoot(player.position);
+                float rate = rapidFire ? fireRate * 0.4f : fireRate;
+                player.shootCooldown = rate;
+            }
+        }
+    }
+    
+    // Where one step of `in` takes a rocket; co-op clients predict with it too
+    sf::Vector2f moveRocket(sf::Vector2f position, const PlayerInput& in) const {
+        sf::Vector2f movement(0, 0);
+        if (in.left) movement.x = -playerSpeed;
+        if (in.right) movement.x = playerSpeed;
+        if (in.up) movement.y = -playerSpeed;
+        if (in.down) movement.y = playerSpeed;
+        
+        sf::Vector2f newPos = position + movement;
+        if (newPos.x > 0 && newPos.x < width - 50)
+            position.x += movement.x;
+        if (newPos.y > 0 && newPos.y < height - 60)
+            position.y += movement.y;
+        return position;
+    }
+    
+    // Side by side at the bottom, centred as a group
+    sf::Vector2f spawnPosition(int player) const {
+        float spread = (player - (playerCount - 1) * 0.5f) * 80.0f;
+        return sf::Vector2f(width / 2.0f - 25 + spread, height - 100.0f);
+    }
+    
+    void placePlayers() {
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            players[p].position = spawnPosition(p);
+            players[p].prevPosition = players[p].position;
+            players[p].shootCooldown = 0.0f;
+        }
+    }
+    
+    sf::FloatRect rocketBounds(int player) const {
+        sf::FloatRect box = rocketBox;
+        box.position += players[player].position;
+        return box;
+    }
+    
+    void shoot(sf::Vector2f rocketPos) {
+        
+        if (hasTripleShot) {
+            // Triple shot - 3 bullets
+            for (int i = -1; i <= 1; i++) {
+                if (!addBullet(sf::Vector2f(rocketPos.x + 22 + (i * 15), rocketPos.y - 10), true)) return;
+                createMuzzleFlash(sf::Vector2f(rocketPos.x + 25 + (i * 15), rocketPos.y));
+            }
+        } else {
+            // Single shot
+            if (!addBullet(sf::Vector2f(rocketPos.x + 22, rocketPos.y - 10), false)) return;
+            createMuzzleFlash(sf::Vector2f(rocketPos.x + 25, rocketPos.y));
+        }
+    }
+    
+    bool addBullet(sf::Vector2f position, bool tripleShot) {
+        uint32_t row = bullets.create();
+        if (row == BulletTable::NO_ROW) return false;
+        bullets.get<Position>(row).value = position;
+        bullets.get<BulletKind>(row).tripleShot = tripleShot;
+        bullets.get<Trail>(row) = Trail{{}, 0, 0};
+        bullets.get<Trail>(row).push(position);
+        return true;
+    }
+    
+    void spawnEnemy() {
+        if (enemies.size() == enemies.capacity()) return;
+        
+        // Level-based enemy distribution, precomputed into the level's spawn table
+        const LevelDef& level = waves.level(currentLevel);
+        int type = level.spawnTable[spawnRng.nextInt(SPAWN_TABLE_SIZE)];
+        float x = static_cast<float>(spawnRng.nextInt(width - 50));
+        addEnemy(type, sf::Vector2f(x, waves.archetype(type).spawnY));
+    }
+    
+    void spawnPowerUp(sf::Vector2f position) {
+        if (lootRng.nextInt(100) < 35) { // 35% chance
+            uint32_t row = powerUps.create();
+            if (row == PowerUpTable::NO_ROW) return;
+            
+            int type = lootRng.nextInt(3);
+            powerUps.get<Position>(row).value = position;
+            powerUps.get<PowerUpKind>(row) = PowerUpKind{static_cast<PowerUpType>(type), 0.0f};
+        }
+    }
+    
+    void createExplosion(sf::Vector2f position, sf::Color color) {
+        sf::Color endColor(color.r / 2, color.g / 2, color.b / 2, 0);
+        for (int i = 0; i < 25; i++) {
+            float radius = static_cast<float>(fxRng.nextInt(4) + 2);
+            float angle = fxRng.nextInt(360) * PI / 180.0f;
+            float speed = static_cast<float>(fxRng.nextInt(4) + 3);
+            sf::Vector2f velocity(cos(angle) * speed, sin(angle) * speed);
+            
+            particles.emit(position, velocity, 0.8f, radius, color, endColor);
+        }
+        
+        screenShake = 0.3f;
+    }
+    
+    void createMuzzleFlash(sf::Vector2f position) {
+        sf::Color startColor = hasTripleShot ? neonYellow : neonCyan;
+        for (int i = 0; i < 5; i++) {
+            float angle = (-90 + (fxRng.nextInt(40) - 20)) * PI / 180.0f;
+            float speed = static_cast<float>(fxRng.nextInt(2) + 1);
+            sf::Vector2f velocity(cos(angle) * speed, sin(angle) * speed);
+            
+            particles.emit(position, velocity, 0.2f, 2.0f, startColor, sf::Color(100, 100, 0, 0));
+        }
+    }
+    
+    void startLevelTransition() {
+        levelTransition = true;
+        levelTransitionTimer = 3.0f;
+        currentLevel++;
+        enemiesKilledInLevel = 0;
+        
+        applyLevel(currentLevel);
+        
+        // Clear enemies and bullets
+        enemies.clear();
+        bullets.clear();
+        projectiles.clear();
+        
+        int boss = waves.level(currentLevel).bossArchetype;
+        if (boss >= 0) spawnBoss(boss);
+        logEvent(GameEventType::LEVEL_START, boss + 1, currentLevel);
+    }
+    
+    // Difficulty settings of level `number`
+    void applyLevel(int number) {
+        const LevelDef& level = waves.level(number);
+        baseEnemySpeed = level.enemySpeed;
+        spawnInterval = level.spawnInterval;
+        enemiesNeededForNextLevel = level.killsToAdvance;
+    }
+    
+    // Set on spawn; levels only change with the screen cleared, so it holds for the enemy's life
+    float enemySpeed(int type) const {
+        const EnemyArchetype& archetype = waves.archetype(type);
+        if (archetype.fixedSpeed > 0) return archetype.fixedSpeed;   // e.g. the slow, heavy boss
+        return baseEnemySpeed * archetype.speedScale;
+    }
+    
+    // Queues an event for the log; just a null check without --event-log
+    void logEvent(GameEventType type, int detail = 0, int value = 0, sf::Vector2f at = sf::Vector2f()) {
+        if (!eventLog) return;
+        auto pixel = [](float v) { return static_cast<int16_t>(std::clamp(v, -32768.0f, 32767.0f)); };
+        eventLog->push(GameEvent{static_cast<uint32_t>(stepCount), type, static_cast<uint8_t>(currentLevel),
+                                 static_cast<uint16_t>(detail), value, pixel(at.x), pixel(at.y)});
+    }
+    
+    // One fixed simulation step
+    void step() {
+        PROFILE_ZONE("update");
+        uint8_t inputBits = players[0].input.toBits();
+        for (int p = 0; p < playerCount; p++) {
+            players[p].prevPosition = players[p].position;
+        }
+        applyInput();
+        update(SIM_DT);
+        stepCount++;
+        
+        if (recording) {
+            replay.record(inputBits, stateHash());
+        }
+    }
+    
+    // Hash of the gameplay state (cosmetic particles, trails and stars excluded)
+    uint32_t stateHash() const {
+        StateHash hash;
+        hash.add(score);
+        hash.add(lives);
+        hash.add(currentLevel);
+        hash.add(enemiesKilledInLevel);
+        hash.add(combo);
+        hash.add(gameOver);
+        hash.add(levelTransition);
+        for (int p = 0; p < playerCount; p++) {
+            hash.add(players[p].position);
+        }
+        for (uint32_t row = 0; row < bullets.size(); row++) {
+            hash.add(bullets.get<Position>(row).value);
+        }
+        for (uint32_t row = 0; row < enemies.size(); row++) {
+            hash.add(enemies.get<Position>(row).value);
+            hash.add(enemies.get<Health>(row).current);
+            hash.add(enemies.get<EnemyKind>(row).archetype);
+        }
+        for (uint32_t row = 0; row < powerUps.size(); row++) {
+            hash.add(powerUps.get<Position>(row).value);
+            hash.add(powerUps.get<PowerUpKind>(row).type);
+        }
+        for (size_t i = 0; i < projectiles.size(); i++) {
+            hash.add(projectiles.position(i));
+        }
+        return hash.value;
+    }
+    
+    void update(float deltaTime) {
+        if (gameOver) return;
+        
+        // Level transition
+        if (levelTransition) {
+            levelTransitionTimer -= deltaTime;
+            if (levelTransitionTimer <= 0) {
+                levelTransition = false;
+            }
+            return;
+        }
+        
+        stageDelta = deltaTime;
+        updateStages.run(jobs);
+    }
+    
+    void updateGameplay(float deltaTime) {
+        PROFILE_ZONE("gameplay");
+        stepArena.reset();
+        updateTimers(deltaTime);
+        updateBullets();
+        updateEnemies();
+        updatePowerUps(deltaTime);
+        resolveBulletHits();
+        updateProjectiles();
+        
+        // Level progression
+        if (!levelTransition && currentLevel < waves.levelCount() && enemiesKilledInLevel >= enemiesNeededForNextLevel) {
+            startLevelTransition();
+        }
+        
+        collectPowerUps();
+        
+        if (gameOver) logEvent(GameEventType::GAME_OVER, lives > 0, score);   // update() stops here until a restart
+    }
+    
+    // Cooldowns, power-up timers, screen shake and the enemy spawn clock
+    void updateTimers(float deltaTime) {
+        PROFILE_ZONE("timers");
+        for (int p = 0; p < playerCount; p++) {
+            players[p].shootCooldown -= deltaTime;
+        }
+        spawnTimer += deltaTime;
+        comboTimer -= deltaTime;
+        powerUpSpawnTimer += deltaTime;
+        
+        if (comboTimer <= 0 && combo > 0) {
+            logEvent(GameEventType::COMBO_END, 0, combo);
+            combo = 0;
+        }
+        
+        // Power-up timers
+        if (rapidFire) {
+            rapidFireTimer -= deltaTime;
+            if (rapidFireTimer <= 0) rapidFire = false;
+        }
+        if (hasShield) {
+            shieldTimer -= deltaTime;
+            if (shieldTimer <= 0) hasShield = false;
+        }
+        if (hasTripleShot) {
+            tripleShotTimer -= deltaTime;
+            if (tripleShotTimer <= 0) hasTripleShot = false;
+        }
+        if (patternCooldown > 0) patternCooldown -= deltaTime;
+        
+        updateShake(deltaTime);
+        
+        // Spawn enemies (none while a boss is alive)
+        if (spawnTimer >= spawnInterval) {
+            if (!enemies.isAlive(bossEntity)) {
+                spawnEnemy();
+            }
+            spawnTimer = 0;
+        }
+    }
+    
+    // Co-op clients run this without the rest of the step
+    void updateShake(float deltaTime) {
+        if (screenShake > 0) {
+            screenShake -= deltaTime;
+            shakeOffset = sf::Vector2f(
+                (fxRng.nextInt(20) - 10) * screenShake,
+                (fxRng.nextInt(20) - 10) * screenShake
+            );
+        } else {
+            shakeOffset = sf::Vector2f(0, 0);
+        }
+    }
+    
+    void updateBullets() {
+        PROFILE_ZONE("bullets");
+        Position* position = bullets.column<Position>();
+        for (uint32_t row = 0; row < bullets.size();) {
+            position[row].value.y -= bulletSpeed;
+            
+            // The last row moves in here, so look at this row again
+            if (position[row].value.y < -20) {
+                bullets.destroy(row);
+                continue;
+            }
+            row++;
+        }
+    }
+    
+    void updateEnemies() {
+        PROFILE_ZONE("enemies");
+        uint32_t boss = enemies.rowOf(bossEntity);
+        if (boss != EnemyTable::NO_ROW) steerBoss(boss);
+        
+        Position* position = enemies.column<Position>();
+        const Velocity* velocity = enemies.column<Velocity>();
+        for (uint32_t row = 0; row < enemies.size(); row++) {
+            position[row].value += velocity[row].value;
+        }
+        
+        // Enemies that reached the bottom
+        for (uint32_t row = 0; row < enemies.size();) {
+            if (position[row].value.y > height) {
+                if (!hasShield) {
+                    lives--;
+                    logEvent(GameEventType::LIFE_LOST, enemies.get<EnemyKind>(row).archetype, lives, position[row].value);
+                }
+                createExplosion(position[row].value, sf::Color::Red);
+                enemies.destroy(row);
+                
+                if (lives <= 0) gameOver = true;
+                continue;
+            }
+            row++;
+        }
+    }
+    
+    // A boss comes down to its station, then sways from side to side
+    void steerBoss(uint32_t row) {
+        sf::Vector2f position = enemies.get<Position>(row).value;
+        sf::Vector2f& velocity = enemies.get<Velocity>(row).value;
+        if (position.y >= BOSS_STATION_Y && velocity.y > 0) {
+            velocity = sf::Vector2f(BOSS_SWAY_SPEED, 0);
+        }
+        float right = width - waves.archetype(enemies.get<EnemyKind>(row).archetype).width;
+        if ((position.x <= 0 && velocity.x < 0) || (position.x >= right && velocity.x > 0)) {
+            velocity.x = -velocity.x;
+        }
+    }
+    
+    void updatePowerUps(float deltaTime) {
+        PROFILE_ZONE("powerups");
+        Position* position = powerUps.column<Position>();
+        PowerUpKind* kind = powerUps.column<PowerUpKind>();
+        for (uint32_t row = 0; row < powerUps.size();) {
+            position[row].value.y += 2;
+            kind[row].age += deltaTime;
+            
+            if (position[row].value.y > height) {
+                powerUps.destroy(row);
+                continue;
+            }
+            row++;
+        }
+    }
+    
+    // Collision: bullets vs enemies, swept over the whole step so a bullet
+    // can't skip over an enemy between two steps. A bullet hits the enemy
+    // it reaches first.
+    void resolveBulletHits() {
+        PROFILE_ZONE("collision");
+        sweptEnemies.clear(enemies.size());
+        enemyGrid.clear(enemies.size());
+        const Velocity* velocity = enemies.column<Velocity>();
+        for (uint32_t row = 0; row < enemies.size(); row++) {
+            int index = sweptEnemies.add(enemyBounds(row), velocity[row].value);
+            enemyGrid.add(sweptEnemies.sweptBounds(index));
+        }
+        enemyGrid.build();
+        
+        // Enemy rows stay put until the dead are removed below
+        sf::Vector2f bulletMotion(0, -bulletSpeed);
+        FrameVector<int> hitCandidates(stepArena);
+        for (uint32_t bullet = 0; bullet < bullets.size();) {
+            sf::FloatRect box = bulletBounds(bullet);
+            hitCandidates.clear();
+            enemyGrid.forEachHit(SweptTargets::sweptBounds(box, bulletMotion), [&](int i) { hitCandidates.push_back(i); });
+            int hit = sweptEnemies.firstContact(box, bulletMotion, hitCandidates.data(), hitCandidates.size());
+            if (hit < 0) {
+                bullet++;
+                continue;
+            }
+            
+            uint32_t row = static_cast<uint32_t>(hit);
+            Health& health = enemies.get<Health>(row);
+            bullets.destroy(bullet);
+            health.current--;
+            
+            if (health.current <= 0) {
+                int type = enemies.get<EnemyKind>(row).archetype;
+                const EnemyArchetype& archetype = waves.archetype(type);
+                if (archetype.flags & ARCHETYPE_ENDS_GAME) {
+                    gameOver = true;   // OR create victory screen
+                }
+                int points = archetype.bonus + archetype.points * currentLevel * (combo + 1);
+                score += points;
+                
+                combo++;
+                comboTimer = 2.f;
+                enemiesKilledInLevel++;
+                
+                sf::Vector2f position = enemies.get<Position>(row).value;
+                logEvent(GameEventType::KILL, type, points, position);
+                if (enemies.rowOf(bossEntity) == row) logEvent(GameEventType::BOSS_DEFEATED, type, 0, position);
+                createExplosion(position, sf::Color(archetype.color[0], archetype.color[1], archetype.color[2], archetype.color[3]));
+                spawnPowerUp(position);
+                
+                health.current = -999; // mark for removal
+            }
+        }
+        
+        // Remove dead enemies AFTER bullet loop
+        for (uint32_t row = 0; row < enemies.size();) {
+            if (enemies.get<Health>(row).current < 0) {
+                enemies.destroy(row);
+                continue;
+            }
+            row++;
+        }
+    }
+    
+    // Boss patterns, then every enemy projectile moved and tested against the
+    // players in one bulk pass, then the hits resolved in projectile order.
+    // With a shield up a projectile that reaches it is absorbed.
+    void updateProjectiles() {
+        PROFILE_ZONE("projectiles");
+        fireBossPattern();
+        moveProjectiles();
+        
+        int hitPlayer = -1;
+        projectiles.removeMarked([&](int player, sf::Vector2f) {
+            if (!hasShield && hitPlayer < 0) hitPlayer = player;
+        });
+        if (hitPlayer >= 0) projectileHit(hitPlayer);
+    }
+    
+    // Fires the volley due this step, if any. The pattern clock only runs
+    // while the boss holds its station; co-op clients call this too.
+    void fireBossPattern() {
+        uint32_t row = enemies.rowOf(bossEntity);
+        if (row == EnemyTable::NO_ROW) return;
+        sf::Vector2f position = enemies.get<Position>(row).value;
+        if (position.y < BOSS_STATION_Y) return;
+        
+        int step = patternStep++;
+        if (patternCooldown > 0) return;
+        
+        int loop = 0;
+        for (const BossPattern& pattern : BOSS_PATTERNS) loop += pattern.steps;
+        int into = step % loop;
+        int index = 0;
+        while (into >= BOSS_PATTERNS[index].steps) into -= BOSS_PATTERNS[index++].steps;
+        
+        const BossPattern& pattern = BOSS_PATTERNS[index];
+        const Health& health = enemies.get<Health>(row);
+        int interval = health.current * 2 < health.max ? std::max(pattern.interval / 2, 1) : pattern.interval;
+        if (into % interval != 0) return;
+        
+        const EnemyArchetype& archetype = waves.archetype(enemies.get<EnemyKind>(row).archetype);
+        sf::Vector2f muzzle = position + sf::Vector2f(archetype.width / 2, archetype.height * 0.75f);
+        firePattern(pattern, into / interval, muzzle);
+    }
+    
+    // Volley number `volley` of `pattern` from `origin`
+    void firePattern(const BossPattern& pattern, int volley, sf::Vector2f origin) {
+        float radius = PROJECTILE_RADII[pattern.style];
+        uint8_t style = static_cast<uint8_t>(pattern.style);
+        switch (pattern.kind) {
+            case PatternKind::SPIRAL:
+                for (int i = 0; i < pattern.count; i++) {
+                    float angle = volley * pattern.spread + i * 2 * PI / pattern.count;
+                    projectiles.emit(origin, sf::Vector2f(cos(angle), sin(angle)) * pattern.speed, radius, style);
+                }
+                break;
+            case PatternKind::AIMED_FAN: {
+                sf::Vector2f toward = nearestPlayerCore(origin) - origin;
+                float aim = std::atan2(toward.y, toward.x);
+                for (int i = 0; i < pattern.count; i++) {
+                    float angle = aim + pattern.spread * (static_cast<float>(i) / (pattern.count - 1) - 0.5f);
+                    projectiles.emit(origin, sf::Vector2f(cos(angle), sin(angle)) * pattern.speed, radius, style);
+                }
+                break;
+            }
+            case PatternKind::RING:
+                // Starts as a circle round the boss rather than a point
+                for (int i = 0; i < pattern.count; i++) {
+                    float angle = volley * pattern.spread + i * 2 * PI / pattern.count;
+                    sf::Vector2f direction(cos(angle), sin(angle));
+                    projectiles.emit(origin + direction * 40.0f, direction * pattern.speed, radius, style);
+                }
+                break;
+        }
+    }
+    
+    sf::Vector2f nearestPlayerCore(sf::Vector2f from) const {
+        sf::Vector2f nearest = players[0].position + PLAYER_CORE;
+        for (int p = 1; p < playerCount; p++) {
+            sf::Vector2f core = players[p].position + PLAYER_CORE;
+            sf::Vector2f a = core - from;
+            sf::Vector2f b = nearest - from;
+            if (a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y) nearest = core;
+        }
+        return nearest;
+    }
+    
+    // Moves every projectile a step and marks the ones on a player (their
+    // core, or the shield while it is up) or off screen. Nothing is hit
+    // once the game is over.
+    void moveProjectiles() {
+        ProjectileSystem::Target targets[MAX_PLAYERS];
+        for (int p = 0; p < playerCount; p++) {
+            sf::Vector2f centre = players[p].position + (hasShield ? sf::Vector2f(25, 25) : PLAYER_CORE);
+            targets[p] = ProjectileSystem::Target{centre.x, centre.y, hasShield ? shield.getRadius() : PLAYER_HITBOX_RADIUS};
+        }
+        int targetCount = gameOver ? 0 : playerCount;
+        sf::FloatRect area(sf::Vector2f(-20, -20), sf::Vector2f(width + 40.0f, height + 40.0f));
+        jobs.parallelFor(projectiles.size(), PROJECTILE_JOB_ITEMS, [&](size_t begin, size_t end) {
+            PROFILE_ZONE("projectiles.chunk");
+            projectiles.integrate(begin, end, targets, targetCount, area);
+        });
+    }
+    
+    // A projectile reached a player's core. The screen is cleared and the
+    // boss holds fire for a moment, so the next life doesn't start in a hail.
+    void projectileHit(int player) {
+        sf::Vector2f core = players[player].position + PLAYER_CORE;
+        lives--;
+        logEvent(GameEventType::LIFE_LOST, std::max(waves.level(currentLevel).bossArchetype, 0), lives, core);
+        createExplosion(core, player == 0 ? neonCyan : neonPink);
+        projectiles.clear();
+        patternCooldown = PATTERN_GRACE;
+        
+        if (lives <= 0) gameOver = true;
+    }
+    
+    // Collision: player vs power-ups
+    void collectPowerUps() {
+        PROFILE_ZONE("pickups");
+        powerUpGrid.clear(powerUps.size());
+        for (uint32_t row = 0; row < powerUps.size(); row++) {
+            powerUpGrid.add(powerUpBounds(row));
+        }
+        powerUpGrid.build();
+        
+        FrameVector<int> pickedUp(stepArena);   // grid index == table row
+        for (int p = 0; p < playerCount; p++) {
+            powerUpGrid.forEachHit(rocketBounds(p), [&](int i) { pickedUp.push_back(i); });
+        }
+        std::sort(pickedUp.begin(), pickedUp.end());
+        pickedUp.erase(std::unique(pickedUp.begin(), pickedUp.end()), pickedUp.end());   // touched by both players
+        
+        for (int row : pickedUp) {
+            PowerUpType type = powerUps.get<PowerUpKind>(row).type;
+            logEvent(GameEventType::PICKUP, static_cast<int>(type), 0, powerUps.get<Position>(row).value);
+            switch (type) {
+                case PowerUpType::RAPID_FIRE:
+                    rapidFire = true;
+                    rapidFireTimer = 8.0f;
+                    break;
+                case PowerUpType::SHIELD:
+                    hasShield = true;
+                    shieldTimer = 10.0f;
+                    break;
+                case PowerUpType::TRIPLE_SHOT:
+                    hasTripleShot = true;
+                    tripleShotTimer = 12.0f;
+                    break;
+            }
+        }
+        // Highest row first, so no row still to be removed gets moved
+        for (auto it = pickedUp.rbegin(); it != pickedUp.rend(); ++it) {
+            powerUps.destroy(static_cast<uint32_t>(*it));
+        }
+    }
+    
+    // Items per job for each parallel loop, from what one item costs.
+    // Particles and projectiles are a few ns each, so small jobs would cost
+    // more to hand out than to run. A trail push or a star move costs more,
+    // and those tables are small, so they are cut into about 4 jobs at
+    // their usual sizes (up to MAX_BULLETS trails, 200 stars).
+    static constexpr size_t PARTICLE_JOB_ITEMS = 4096;
+    static constexpr size_t PROJECTILE_JOB_ITEMS = 4096;
+    static constexpr size_t TRAIL_JOB_ITEMS = 128;
+    static constexpr size_t STAR_JOB_ITEMS = 50;
+    
+    void updateParticles(float deltaTime) {
+        PROFILE_ZONE("particles");
+        jobs.parallelFor(particles.size(), PARTICLE_JOB_ITEMS, [&](size_t begin, size_t end) {
+            PROFILE_ZONE("particles.chunk");
+            particles.integrate(begin, end, deltaTime);
+        });
+        particles.removeDead();
+    }
+    
+    // Each bullet remembers where it has been; the ring overwrites its
+    // oldest entry, so cost and memory are fixed per bullet
+    void updateTrails() {
+        PROFILE_ZONE("trails");
+        const Position* position = bullets.column<Position>();
+        Trail* trail = bullets.column<Trail>();
+        jobs.parallelFor(bullets.size(), TRAIL_JOB_ITEMS, [&](size_t begin, size_t end) {
+            PROFILE_ZONE("trails.chunk");
+            for (size_t row = begin; row < end; row++) {
+                trail[row].push(position[row].value);
+            }
+        });
+    }
+    
+    void updateStars() {
+        PROFILE_ZONE("stars");
+        float scroll = currentLevel * 0.5f;
+        jobs.parallelFor(stars.size(), STAR_JOB_ITEMS, [&](size_t begin, size_t end) {
+            PROFILE_ZONE("stars.chunk");
+            for (size_t i = begin; i < end; i++) {
+                stars[i].move(sf::Vector2f(0, starSpeeds[i] * scroll));
+            }
+        });
+        // Wrapping draws from starRng, so it stays serial and in index order
+        for (auto& star : stars) {
+            if (star.getPosition().y > height) {
+                star.setPosition(sf::Vector2f(static_cast<float>(starRng.nextInt(width)), -5));
+            }
+        }
+    }
+    
+    // Render positions lag the simulation by (1 - renderAlpha) of a step, so
+    // an entity moving by `velocity` per step is drawn this far back
+    sf::Vector2f lerpOffset(sf::Vector2f velocity) const {
+        return velocity * (renderAlpha - 1.0f);
+    }
+    
+    void render() {
+        drawFrame();
+        
+        PROFILE_ZONE("display");
+        window->display();
+    }
+    
+    // Into the window, or into the software canvas when there is none. The
+    // canvas gets the same vertices; the shake moves them instead of the view.
+    void drawFrame() {
+        PROFILE_ZONE("render");
+        const sf::Color background(5, 5, 20);
+        if (window) {
+            window->clear(background);
+            sf::View view = window->getDefaultView();
+            view.move(shakeOffset);
+            window->setView(view);
+        } else {
+            canvas->clear(background);
+        }
+        
+        drawBackground();
+        drawParticles();
+        drawSprites();
+        drawProjectiles();
+        
+        // Reset view for UI
+        if (window) {
+            window->setView(window->getDefaultView());
+            drawHud(*window);
+        } else {
+            drawHud(*canvas);
+        }
+        
+#ifdef PROFILER_ENABLED
+        if (window && showProfiler) Profiler::instance().drawOverlay(*window, fontLoaded ? &font : nullptr);
+#endif
+    }
+    
+    // Stars and bullet trails
+    void drawBackground() {
+        PROFILE_ZONE("render.background");
+        backgroundBatch.clear();
+        for (size_t i = 0; i < stars.size(); i++) {
+            float size = stars[i].getRadius() * 2;
+            sf::Vector2f pos = stars[i].getPosition() + lerpOffset(sf::Vector2f(0, starSpeeds[i] * currentLevel * 0.5f));
+            backgroundBatch.addStretched(dotRegion, sf::FloatRect(pos, sf::Vector2f(size, size)), stars[i].getFillColor());
+        }
+        
+        // Trails are drawn through the bullet's centre, moved with it
+        sf::Vector2f trailOffset = bulletBox.size * 0.5f + bulletBox.position + lerpOffset(sf::Vector2f(0, -bulletSpeed));
+        sf::Vector2f points[TRAIL_LENGTH];
+        for (uint32_t row = 0; row < bullets.size(); row++) {
+            const Trail& trail = bullets.get<Trail>(row);
+            for (int i = 0; i < trail.count; i++) {
+                points[i] = trail.points[(trail.head - trail.count + i + TRAIL_LENGTH) % TRAIL_LENGTH] + trailOffset;
+            }
+            sf::Color color = bullets.get<BulletKind>(row).tripleShot ? sf::Color(255, 255, 0, 100) : sf::Color(0, 255, 255, 100);
+            backgroundBatch.addRibbon(solidRegion, points, static_cast<size_t>(trail.count), 4.0f, color);
+        }
+        if (window) {
+            backgroundBatch.draw(*window, atlas.texture());
+        } else {
+            backgroundBatch.draw(*canvas, atlas.pixels(), -shakeOffset);
+        }
+    }
+    
+    // One draw call for all particles, added on top so overlapping glows
+    // brighten instead of covering each other
+    void drawParticles() {
+        PROFILE_ZONE("render.particles");
+        particles.buildVertices(particleVertices, renderAlpha, glowRegion.texRect);
+        if (window) {
+            sf::RenderStates states(&atlas.texture());
+            states.blendMode = sf::BlendAdd;
+            window->draw(particleVertices, states);
+        } else {
+            canvas->drawTriangles(particleVertices, &atlas.pixels(), -shakeOffset, SoftwareCanvas::Blend::Add);
+        }
+    }
+    
+    // Everything else goes into one batch, in back-to-front order
+    void drawSprites() {
+        PROFILE_ZONE("render.sprites");
+        spriteBatch.clear();
+        
+        // Power-ups
+        sf::Vector2f powerUpOffset = lerpOffset(sf::Vector2f(0, 2));
+        for (uint32_t row = 0; row < powerUps.size(); row++) {
+            float scale = powerUpScale(row);
+            spriteBatch.add(powerUpRegions[static_cast<int>(powerUps.get<PowerUpKind>(row).type)],
+                            powerUps.get<Position>(row).value + powerUpOffset, sf::Color::White,
+                            sf::Vector2f(15.f, 15.f), sf::Vector2f(scale, scale));
+        }
+        
+        // Players with shield
+        for (int p = 0; p < playerCount; p++) {
+            const Player& player = players[p];
+            sf::Vector2f rocketPos = player.position + lerpOffset(player.position - player.prevPosition);
+            if (hasShield) {
+                spriteBatch.add(shieldRegion, rocketPos + sf::Vector2f(25, 25), sf::Color::White, shield.getOrigin());
+            }
+            
+            // Rocket exhaust flames
+            if (!levelTransition && !gameOver) {
+                spriteBatch.add(flameRegions[0], rocketPos + sf::Vector2f(19, 45));
+                spriteBatch.add(flameRegions[1], rocketPos + sf::Vector2f(21, 50));
+            }
+            
+            spriteBatch.add(rocketRegions[p], rocketPos);
+        }
+        
+        // Bullets
+        sf::Vector2f bulletOffset = lerpOffset(sf::Vector2f(0, -bulletSpeed));
+        for (uint32_t row = 0; row < bullets.size(); row++) {
+            int variant = bullets.get<BulletKind>(row).tripleShot ? 1 : 0;
+            spriteBatch.add(bulletRegions[variant], bullets.get<Position>(row).value + bulletOffset);
+        }
+        
+        // Enemies with health bars
+        for (uint32_t row = 0; row < enemies.size(); row++) {
+            int type = enemies.get<EnemyKind>(row).archetype;
+            sf::Vector2f pos = enemies.get<Position>(row).value + lerpOffset(enemies.get<Velocity>(row).value);
+            spriteBatch.add(enemyRegions[type], pos);
+            
+            const Health& health = enemies.get<Health>(row);
+            if (health.max > 1) {
+                const EnemyArchetype& archetype = waves.archetype(type);
+                bool isBoss = archetype.flags & ARCHETYPE_BOSS;
+                float barHeight = isBoss ? 8.f : 4.f;
+                float healthPercent = static_cast<float>(health.current) / health.max;
+                sf::Color barColor = healthPercent > 0.6f ? sf::Color::Green
+                                   : healthPercent > 0.3f ? sf::Color::Yellow
+                                   : sf::Color::Red;
+                sf::Vector2f barPos(pos.x, pos.y - 8.f);
+                spriteBatch.addStretched(solidRegion, sf::FloatRect(barPos, sf::Vector2f(archetype.width, barHeight)),
+                                         isBoss ? sf::Color(40, 40, 40) : sf::Color(50, 50, 50));
+                spriteBatch.addStretched(solidRegion, sf::FloatRect(barPos, sf::Vector2f(archetype.width * healthPercent, barHeight)),
+                                         barColor);
+            }
+        }
+        
+        if (window) {
+            spriteBatch.draw(*window, atlas.texture());
+        } else {
+            spriteBatch.draw(*canvas, atlas.pixels(), -shakeOffset);
+        }
+    }
+    
+    // Enemy projectiles over everything but the HUD, in one draw call
+    void drawProjectiles() {
+        PROFILE_ZONE("render.projectiles");
+        projectiles.buildVertices(projectileVertices, renderAlpha, projectileSprites);
+        if (window) {
+            window->draw(projectileVertices, sf::RenderStates(&atlas.texture()));
+        } else {
+            canvas->drawTriangles(projectileVertices, &atlas.pixels(), -shakeOffset);
+        }
+    }
+    
+    // Counters only re-layout when their value changed. `Target` is the
+    // window or the software canvas.
+    template <typename Target>
+    void drawHud(Target& target) {
+        PROFILE_ZONE("render.hud");
+        if (fontLoaded) {
+            scoreText->set(score);
+            livesText->set(lives);
+            levelText->set(currentLevel);
+            scoreText->draw(target);
+            livesText->draw(target);
+            levelText->draw(target);
+            
+            if (combo > 1) {
+                comboText->set(combo);
+                comboText->draw(target);
+            }
+            
+            // Draw power-up indicators
+            float indicatorY = 110;
+            if (rapidFire) {
+                powerUpPanels[static_cast<int>(PowerUpType::RAPID_FIRE)].draw(target, sf::Vector2f(18, indicatorY - 2));
+                indicatorY += 40;
+            }
+            if (hasShield) {
+                powerUpPanels[static_cast<int>(PowerUpType::SHIELD)].draw(target, sf::Vector2f(18, indicatorY - 2));
+                indicatorY += 40;
+            }
+            if (hasTripleShot) {
+                powerUpPanels[static_cast<int>(PowerUpType::TRIPLE_SHOT)].draw(target, sf::Vector2f(18, indicatorY - 2));
+            }
+            
+            // Level transition screen
+            if (levelTransition) {
+                transitionPanel.draw(target, sf::Vector2f(0, 0));
+                levelUpText->set(currentLevel);
+                levelUpText->draw(target);
+            }
+            
+            if (gameOver) {
+                gameOverPanel.draw(target, sf::Vector2f(0, 0));
+                finalScoreText->set(score);
+                levelReachedText->set(currentLevel);
+                finalScoreText->draw(target);
+                levelReachedText->draw(target);
+            }
+            
+            if (showFrameTimes) {
+                const TimeHistogram& frames = pacer.histogram();
+                char line[96];
+                std::snprintf(line, sizeof(line), "FRAME %.1f MS  P50 %.1f  P95 %.1f  P99 %.1f  MAX %.1f", pacer.targetMs(),
+                              frames.percentileMs(50), frames.percentileMs(95), frames.percentileMs(99), frames.maxMs());
+                frameTimesText.setString(line);
+                frameTimesText.draw(target);
+            }
+        }
+    }
+    
+    void resetGame() {
+        bullets.clear();
+        enemies.clear();
+        particles.clear();
+        powerUps.clear();
+        projectiles.clear();
+        patternStep = 0;
+        patternCooldown = 0.0f;
+        score = 0;
+        lives = 3;
+        currentLevel = 1;
+        enemiesKilledInLevel = 0;
+        applyLevel(currentLevel);
+        combo = 0;
+        comboTimer = 0.0f;
+        gameOver = false;
+        levelTransition = false;
+        levelTransitionTimer = 0.0f;
+        rapidFire = false;
+        rapidFireTimer = 0.0f;
+        hasShield = false;
+        shieldTimer = 0.0f;
+        hasTripleShot = false;
+        tripleShotTimer = 0.0f;
+        spawnTimer = 0.0f;
+        powerUpSpawnTimer = 0.0f;
+        screenShake = 0.0f;
+        shakeOffset = sf::Vector2f(0, 0);
+        placePlayers();
+        rewindCount = 0;   // don't rewind into the previous run
+        logEvent(GameEventType::RUN_START);
+    }
+    
+    // Captures everything gameplay depends on; see Snapshot
+    void saveSnapshot(Snapshot& snapshot) const {
+        PROFILE_ZONE("snapshot.save");
+        SnapshotState& state = snapshot.begin(enemies.rowBytes() + bullets.rowBytes() + powerUps.rowBytes() +
+                                              projectiles.rowBytes());
+        state.stepCount = stepCount;
+        state.seed = seed;
+        state.spawnRng = spawnRng;
+        state.lootRng = lootRng;
+        state.starRng = starRng;
+        state.fxRng = fxRng;
+        state.score = score;
+        state.lives = lives;
+        state.combo = combo;
+        state.currentLevel = currentLevel;
+        state.enemiesKilledInLevel = enemiesKilledInLevel;
+        state.enemiesNeededForNextLevel = enemiesNeededForNextLevel;
+        state.archetypeCount = waves.archetypeCount();
+        state.comboTimer = comboTimer;
+        state.baseEnemySpeed = baseEnemySpeed;
+        state.spawnInterval = spawnInterval;
+        state.spawnTimer = spawnTimer;
+        state.powerUpSpawnTimer = powerUpSpawnTimer;
+        state.rapidFireTimer = rapidFireTimer;
+        state.shieldTimer = shieldTimer;
+        state.tripleShotTimer = tripleShotTimer;
+        state.levelTransitionTimer = levelTransitionTimer;
+        state.screenShake = screenShake;
+        state.patternCooldown = patternCooldown;
+        state.patternStep = patternStep;
+        state.shakeOffset = shakeOffset;
+        state.playerCount = playerCount;
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            state.rocketPositions[p] = players[p].position;
+            state.shootCooldowns[p] = players[p].shootCooldown;
+        }
+        state.gameOver = gameOver;
+        state.levelTransition = levelTransition;
+        state.rapidFire = rapidFire;
+        state.hasShield = hasShield;
+        state.hasTripleShot = hasTripleShot;
+        state.bossRow = enemies.rowOf(bossEntity);
+        state.enemyCount = enemies.size();
+        state.bulletCount = bullets.size();
+        state.powerUpCount = powerUps.size();
+        state.projectileCount = static_cast<uint32_t>(projectiles.size());
+        
+        uint8_t* out = snapshot.rowsOut();
+        out = enemies.writeRows(out);
+        out = bullets.writeRows(out);
+        out = powerUps.writeRows(out);
+        projectiles.writeRows(out);
+    }
+    
+    // Snapshot rows index tables by value; a save file that was cut short,
+    // edited or taken with other levels must not reach them
+    bool rowsInRange(const SnapshotState& state, const uint8_t* rows) const {
+        const uint8_t* kinds = EnemyTable::columnIn<EnemyKind>(rows, state.enemyCount);
+        for (uint32_t i = 0; i < state.enemyCount; i++) {
+            EnemyKind kind;
+            std::memcpy(&kind, kinds + i * sizeof(EnemyKind), sizeof(kind));
+            if (kind.archetype < 0 || kind.archetype >= waves.archetypeCount()) return false;
+        }
+        
+        rows += state.enemyCount * EnemyTable::ROW_SIZE + state.bulletCount * BulletTable::ROW_SIZE;
+        const uint8_t* powerUpKinds = PowerUpTable::columnIn<PowerUpKind>(rows, state.powerUpCount);
+        for (uint32_t i = 0; i < state.powerUpCount; i++) {
+            PowerUpKind kind;
+            std::memcpy(&kind, powerUpKinds + i * sizeof(PowerUpKind), sizeof(kind));
+            if (static_cast<unsigned>(kind.type) > static_cast<unsigned>(PowerUpType::TRIPLE_SHOT)) return false;
+        }
+        
+        rows += state.powerUpCount * PowerUpTable::ROW_SIZE;
+        const uint8_t* styles = ProjectileSystem::stylesIn(rows, state.projectileCount);
+        for (uint32_t i = 0; i < state.projectileCount; i++) {
+            if (styles[i] >= PROJECTILE_STYLES) return false;
+        }
+        return true;
+    }
+    
+    // Puts the game back to `snapshot`. False (and nothing changed) when it
+    // was taken with other levels or doesn't fit the tables.
+    bool loadSnapshot(const Snapshot& snapshot) {
+        PROFILE_ZONE("snapshot.load");
+        const SnapshotState* state = snapshot.state();
+        if (!state || state->archetypeCount != waves.archetypeCount() || state->playerCount < 1 ||
+            state->playerCount > MAX_PLAYERS ||
+            state->enemyCount > enemies.capacity() || state->bulletCount > bullets.capacity() ||
+            state->powerUpCount > powerUps.capacity() || state->projectileCount > projectiles.maxSize() ||
+            snapshot.rowBytes() != state->enemyCount * EnemyTable::ROW_SIZE + state->bulletCount * BulletTable::ROW_SIZE +
+                                   state->powerUpCount * PowerUpTable::ROW_SIZE +
+                                   state->projectileCount * ProjectileSystem::ROW_SIZE ||
+            !rowsInRange(*state, snapshot.rows())) {
+            return false;
+        }
+        
+        stepCount = state->stepCount;
+        seed = state->seed;
+        spawnRng = state->spawnRng;
+        lootRng = state->lootRng;
+        starRng = state->starRng;
+        fxRng = state->fxRng;
+        score = state->score;
+        lives = state->lives;
+        combo = state->combo;
+        currentLevel = state->currentLevel;
+        enemiesKilledInLevel = state->enemiesKilledInLevel;
+        enemiesNeededForNextLevel = state->enemiesNeededForNextLevel;
+        comboTimer = state->comboTimer;
+        baseEnemySpeed = state->baseEnemySpeed;
+        spawnInterval = state->spawnInterval;
+        spawnTimer = state->spawnTimer;
+        powerUpSpawnTimer = state->powerUpSpawnTimer;
+        rapidFireTimer = state->rapidFireTimer;
+        shieldTimer = state->shieldTimer;
+        tripleShotTimer = state->tripleShotTimer;
+        levelTransitionTimer = state->levelTransitionTimer;
+        screenShake = state->screenShake;
+        patternCooldown = state->patternCooldown;
+        patternStep = state->patternStep;
+        shakeOffset = state->shakeOffset;
+        playerCount = state->playerCount;
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            players[p].position = state->rocketPositions[p];
+            players[p].prevPosition = state->rocketPositions[p];
+            players[p].shootCooldown = state->shootCooldowns[p];
+        }
+        gameOver = state->gameOver;
+        levelTransition = state->levelTransition;
+        rapidFire = state->rapidFire;
+        hasShield = state->hasShield;
+        hasTripleShot = state->hasTripleShot;
+        
+        const uint8_t* in = snapshot.rows();
+        enemies.readRows(in, state->enemyCount);
+        in += enemies.rowBytes();
+        bullets.readRows(in, state->bulletCount);
+        in += bullets.rowBytes();
+        powerUps.readRows(in, state->powerUpCount);
+        in += powerUps.rowBytes();
+        projectiles.readRows(in, state->projectileCount);
+        bossEntity = state->bossRow < enemies.size() ? enemies.entityAt(state->bossRow) : Entity();
+        
+        // A recording continues from here as if the undone steps never happened
+        if (recording) {
+            replay.truncate(stepCount);
+            recordingCutTo = std::min(recordingCutTo, stepCount);
+        }
+        logEvent(GameEventType::STATE_LOADED);
+        return true;
+    }
+    
+    void run() {
+        while (window && window->isOpen()) {
+            float frameTime = pacer.waitForNextFrame();
+            
+            handleInput();
+            
+            accumulator += frameTime;
+            int steps = 0;
+            while (accumulator >= SIM_DT && steps < MAX_CATCHUP_STEPS) {
+                if (rewinding) {
+                    rewindStep();
+                } else if (session) {
+                    if (inputSource) inputSource->sample(*this, players[localPlayer].input);
+                    session->step(*this);
+                } else {
+                    if (inputSource) inputSource->sample(*this, players[localPlayer].input);
+                    step();
+                    keepSnapshots();
+                }
+                accumulator -= SIM_DT;
+                steps++;
+            }
+            // Drop whatever backlog is left after a hitch rather than
+            // paying for it with extra sim work on the next frames
+            if (accumulator >= SIM_DT) accumulator = std::fmod(accumulator, SIM_DT);
+            
+            renderAlpha = accumulator / SIM_DT;
+            render();
+            PROFILE_FRAME();
+        }
+        
+        if (autosave) {
+            saveSnapshot(autosaveSnapshot);
+            autosave->submit(autosaveSnapshot);
+            autosave.reset();   // waits for the write
+        }
+        
+        const TimeHistogram& frames = pacer.histogram();
+        if (frames.count() > 0) {
+            std::cout << "frame time (target " << pacer.targetMs() << " ms): " << frames.count() << " frames, p50 "
+                      << frames.percentileMs(50) << " ms, p95 " << frames.percentileMs(95) << " ms, p99 "
+                      << frames.percentileMs(99) << " ms, max " << frames.maxMs() << " ms\n";
+        }
+        const TimeHistogram* latency = inputSource ? inputSource->latency() : nullptr;
+        if (latency && latency->count() > 0) {
+            std::cout << "input latency (poll midpoint to step): " << latency->count() << " presses, p50 "
+                      << latency->percentileMs(50) << " ms, p95 " << latency->percentileMs(95) << " ms, p99 "
+                      << latency->percentileMs(99) << " ms, max " << latency->maxMs() << " ms\n";
+        }
+        if (eventLog) eventLog->report();
+        if (session) session->report();
+#ifdef PROFILER_ENABLED
+        Profiler::instance().printAllocationReport();
+#endif
+    }
+    
+    // Rewind snapshots every few steps, and the autosave
+    void keepSnapshots() {
+        if (stepCount % REWIND_INTERVAL == 0) {
+            rewindNewest = (rewindNewest + 1) % REWIND_SNAPSHOTS;
+            rewindCount = std::min(rewindCount + 1, REWIND_SNAPSHOTS);
+            saveSnapshot(rewindBuffer[rewindNewest]);
+        }
+        if (autosave && stepCount % AUTOSAVE_STEPS == 0) {
+            saveSnapshot(autosaveSnapshot);
+            autosave->submit(autosaveSnapshot);
+        }
+    }
+    
+    // Goes back to the newest rewind snapshot and drops it, so holding the
+    // key walks back REWIND_INTERVAL steps per step
+    void rewindStep() {
+        if (rewindCount == 0) return;
+        loadSnapshot(rewindBuffer[rewindNewest]);
+        rewindNewest = (rewindNewest + REWIND_SNAPSHOTS - 1) % REWIND_SNAPSHOTS;
+        rewindCount--;
+    }
+    
+    // Resumes from `path` if it holds a save, then keeps it up to date in the
+    // background. Returns whether the game was resumed.
+    bool enableAutosave(const std::string& path) {
+        Snapshot saved;
+        bool resumed = saved.load(path) && loadSnapshot(saved);
+        autosave = std::make_unique<SnapshotWriter>(path);
+        return resumed;
+    }
+    
+    // A recording only follows a quick load when it still holds every step
+    // up to the save. After a rewind past the save, the steps from there to
+    // the save are gone, and loading would record later inputs at the
+    // wrong steps.
+    bool quickSaveOnRecording() const {
+        const SnapshotState* state = quickSave.state();
+        return !recording || (state && state->stepCount <= recordingCutTo && state->stepCount <= replay.inputs.size());
+    }
+    
+    void startRecording() {
+        recording = true;
+        replay = Replay();
+        replay.seed = seed;
+    }
+    
+    bool saveRecording(const std::string& path) const {
+        return replay.save(path);
+    }
+    
+    // Re-simulates a recorded run and checks it against the recorded state
+    // hashes. Returns false and reports the first step that diverged.
+    bool playReplay(const Replay& recorded) {
+        for (size_t tick = 0; tick < recorded.inputs.size(); tick++) {
+            players[0].input = PlayerInput::fromBits(recorded.inputs[tick]);
+            step();
+            if (!recorded.verify(tick, stateHash())) {
+                size_t from = (tick + 1 - recorded.hashInterval);
+                std::cout << "replay diverged between steps " << from << " and " << tick << "\n";
+                return false;
+            }
+        }
+        std::cout << "replay ok: " << recorded.inputs.size() << " steps, score " << score
+                  << ", level " << currentLevel << "\n";
+        return true;
+    }
+    
+    // One step without a window: restarts after a game over, then samples
+    // the input source and steps (through the co-op session if there is one)
+    void headlessStep() {
+        if (gameOver) {
+            players[localPlayer].input.restart = true;   // goes through step() so recordings see it
+        }
+        if (inputSource) inputSource->sample(*this, players[localPlayer].input);
+        if (session) {
+            session->step(*this);
+        } else {
+            step();
+        }
+    }
+    
+    // Drives the simulation without a window, as fast as the CPU allows
+    // (in real time with a co-op session, which has a peer to keep up with).
+    // Runs that end in game over are restarted so long soaks keep going.
+    // Without an input source the player just sits there.
+    void runHeadless(long long ticks) {
+        int runs = 1;
+        int wins = 0;
+        int bestScore = 0;
+        int bestLevel = 1;
+        bool wasOver = false;   // a co-op restart takes a round trip
+        sf::Clock wallClock;
+        
+        for (long long tick = 0; tick < ticks; tick++) {
+            if (gameOver && !wasOver) {
+                bestScore = std::max(bestScore, score);
+                bestLevel = std::max(bestLevel, currentLevel);
+                if (lives > 0) wins++;   // only the final boss ends a run with lives left
+                runs++;
+            }
+            wasOver = gameOver;
+            if (session) pacer.waitForNextFrame();
+            headlessStep();
+            if (canvas) {
+                int64_t start = inputClockUs();
+                drawFrame();
+                renderTimes.add(inputClockUs() - start);
+            }
+            PROFILE_FRAME();
+        }
+        bestScore = std::max(bestScore, score);
+        bestLevel = std::max(bestLevel, currentLevel);
+        
+        float elapsed = wallClock.getElapsedTime().asSeconds();
+        std::cout << "seed: " << seed << "\n"
+                  << "ticks: " << ticks << "\n"
+                  << "seconds: " << elapsed << "\n"
+                  << "ticks/s: " << (elapsed > 0 ? ticks / elapsed : 0.0f) << "\n"
+                  << "runs: " << runs << "\n"
+                  << "wins: " << wins << "\n"
+                  << "best score: " << bestScore << "\n"
+                  << "best level: " << bestLevel << "\n";
+        if (renderTimes.count() > 0) {
+            std::cout << "software render: " << renderTimes.count() << " frames, mean " << renderTimes.meanMs()
+                      << " ms, p50 " << renderTimes.percentileMs(50) << " ms, p95 " << renderTimes.percentileMs(95)
+                      << " ms, p99 " << renderTimes.percentileMs(99) << " ms, max " << renderTimes.maxMs() << " ms\n";
+        }
+        if (eventLog) eventLog->report();
+        if (session) session->report();
+#ifdef PROFILER_ENABLED
+        Profiler::instance().printAllocationReport();
+#endif
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <string>
+#include "BitmapFont.hpp"
+#include "SoftwareCanvas.hpp"
+
+// snprintf for HudCounter formatters: appends ASCII text to `out`
+template <typename... Args>
+void appendFormatted(std::u32string& out, const char* format, Args... args) {
+    char buffer[64];
+    int length = std::snprintf(buffer, sizeof(buffer), format, args...);
+    length = std::clamp(length, 0, static_cast<int>(sizeof(buffer)) - 1);
+    for (int i = 0; i < length; i++) out.push_back(static_cast<char32_t>(buffer[i]));
+}
+
+// Text bound to one integer. The string is rebuilt and glyph layout rerun
+// only when the value changes, so an unchanged counter costs one compare.
+// The formatter writes into a string the counter keeps, so a change only
+// allocates when the text gets longer than it has been.
+class HudCounter {
+public:
+    using Formatter = std::function<void(int value, std::u32string& out)>;
+
+    HudCounter(const BitmapFont& font, unsigned int size, sf::Color color, Formatter formatter, bool bold = true)
+        : text(font), format(std::move(formatter)) {
+        text.setCharacterSize(size);
+        text.setFillColor(color);
+        if (bold) text.setStyle(sf::Text::Bold);
+    }
+
+    void setPosition(sf::Vector2f position) {
+        text.setPosition(position);
+        centered = false;
+    }
+
+    // Keeps the text horizontally centred on `x` across value changes
+    void centerOn(float x, float y) {
+        centerX = x;
+        topY = y;
+        centered = true;
+        relayout();
+    }
+
+    void set(int value) {
+        if (hasValue && value == shown) return;
+        shown = value;
+        hasValue = true;
+        formatted.clear();
+        format(value, formatted);
+        text.setString(formatted);
+        relayout();
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        target.draw(text);
+    }
+
+    void draw(SoftwareCanvas& target) const {
+        text.draw(target);
+    }
+
+private:
+    void relayout() {
+        if (!centered) return;
+        sf::FloatRect bounds = text.getLocalBounds();
+        text.setPosition(sf::Vector2f(centerX - bounds.size.x / 2, topY));
+    }
+
+    BitmapText text;
+    Formatter format;
+    std::u32string formatted;
+    int shown = 0;
+    bool hasValue = false;
+    bool centered = false;
+    float centerX = 0;
+    float topY = 0;
+};
+
+// Static HUD elements composited once and drawn as one sprite. They are
+// painted on the CPU, so the software renderer can use them too; with a
+// window the result is uploaded to a texture.
+class HudPanel {
+public:
+    bool compose(sf::Vector2u size, const std::function<void(SoftwareCanvas&)>& paint, bool upload) {
+        image.create(size.x, size.y);
+        paint(image);
+        if (!upload) return true;
+        if (!texture.resize(size)) return false;
+        texture.update(image.data());
+        sprite.emplace(texture);
+        return true;
+    }
+
+    void draw(sf::RenderTarget& target, sf::Vector2f position) {
+        if (!sprite) return;
+        sprite->setPosition(position);
+        target.draw(*sprite);
+    }
+
+    void draw(SoftwareCanvas& target, sf::Vector2f position) const {
+        target.drawCanvas(image, position);
+    }
+
+private:
+    SoftwareCanvas image;
+    sf::Texture texture;
+    std::optional<sf::Sprite> sprite;
+};
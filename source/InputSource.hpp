@@ -0,0 +1,129 @@
+#pragma once
+#include <SFML/Window.hpp>
+#include <chrono>
+#include <cstdint>
+#include "TimeHistogram.hpp"
+
+class Game;
+
+// Player controls for one fixed simulation step
+struct PlayerInput {
+    bool left = false;
+    bool right = false;
+    bool up = false;
+    bool down = false;
+    bool fire = false;
+    bool restart = false;   // latched on key press, cleared once a step consumes it
+
+    uint8_t toBits() const {
+        return static_cast<uint8_t>(left | (right << 1) | (up << 2) | (down << 3) | (fire << 4) | (restart << 5));
+    }
+
+    static PlayerInput fromBits(uint8_t bits) {
+        PlayerInput in;
+        in.left = bits & 1;
+        in.right = bits & 2;
+        in.up = bits & 4;
+        in.down = bits & 8;
+        in.fire = bits & 16;
+        in.restart = bits & 32;
+        return in;
+    }
+};
+
+// Microseconds on a steady clock; input events, samples and the frame
+// pacer share it, so latencies and frame times line up
+inline int64_t inputClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Decides the player's controls for one simulation step. May look at (but
+// not change) the game state.
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    // A key went down or up; `time` is on inputClockUs(). Window events
+    // only, so sources that poll or compute their input can ignore these.
+    virtual void keyEvent(sf::Keyboard::Key, bool, int64_t) {}
+
+    // The window lost focus and may miss releases: let go of every key
+    virtual void releaseAll() {}
+
+    // Overwrites the held controls in `input`, called right before each
+    // step. `restart` may only be set, never cleared: window events latch it too.
+    virtual void sample(const Game& game, PlayerInput& input) = 0;
+
+    // Press-to-step delays, for sources driven by real keys. Measured from
+    // the stamp keyEvent() got, not from when the key really went down.
+    virtual const TimeHistogram* latency() const { return nullptr; }
+};
+
+// WASD / arrow keys and Space, tracked from key events.
+//
+// Every press is latched until the next step samples it, so a tap shorter
+// than a frame still moves or fires for one step; held keys count for every
+// step until they are released. All events from one poll land on the first
+// step after it: SFML gives them no real time to place them by.
+class KeyboardInput : public InputSource {
+public:
+    void keyEvent(sf::Keyboard::Key key, bool pressed, int64_t time) override {
+        int index = keyIndex(key);
+        if (index < 0) return;
+        uint16_t bit = static_cast<uint16_t>(1u << index);
+
+        if (!pressed) {
+            held &= static_cast<uint16_t>(~bit);
+        } else if (!(held & bit)) {   // ignore auto-repeat
+            held |= bit;
+            if (!(tapped & bit)) pressTime[index] = time;
+            tapped |= bit;
+        }
+    }
+
+    void releaseAll() override { held = 0; }
+
+    void sample(const Game&, PlayerInput& input) override {
+        uint16_t active = held | tapped;
+        if (tapped) {
+            int64_t now = inputClockUs();
+            for (int i = 0; i < KEY_COUNT; i++) {
+                if (tapped & (1u << i)) delays.add(now - pressTime[i]);
+            }
+            tapped = 0;
+        }
+
+        input.left = active & LEFT_KEYS;
+        input.right = active & RIGHT_KEYS;
+        input.up = active & UP_KEYS;
+        input.down = active & DOWN_KEYS;
+        input.fire = active & FIRE_KEYS;
+    }
+
+    const TimeHistogram* latency() const override { return &delays; }
+
+private:
+    static constexpr int KEY_COUNT = 9;
+    static constexpr uint16_t LEFT_KEYS = 0x003;    // A, Left
+    static constexpr uint16_t RIGHT_KEYS = 0x00C;   // D, Right
+    static constexpr uint16_t UP_KEYS = 0x030;      // W, Up
+    static constexpr uint16_t DOWN_KEYS = 0x0C0;    // S, Down
+    static constexpr uint16_t FIRE_KEYS = 0x100;    // Space
+
+    // Bit index of each key we listen to
+    static int keyIndex(sf::Keyboard::Key key) {
+        using Key = sf::Keyboard::Key;
+        static const Key keys[KEY_COUNT] = {Key::A, Key::Left, Key::D, Key::Right, Key::W, Key::Up,
+                                            Key::S, Key::Down, Key::Space};
+        for (int i = 0; i < KEY_COUNT; i++) {
+            if (keys[i] == key) return i;
+        }
+        return -1;
+    }
+
+    uint16_t held = 0;     // keys down right now
+    uint16_t tapped = 0;   // keys pressed since the last sample
+    int64_t pressTime[KEY_COUNT] = {};
+    TimeHistogram delays{250, 200};   // 0.25 ms buckets up to 50 ms
+};
@@ -0,0 +1,243 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing job scheduler.
+//
+// Every worker owns a bounded queue. Work is spread round-robin over the
+// queues; a worker pops from the back of its own queue and, when that is
+// empty, steals from the front of the others. A thread waiting for jobs to
+// finish runs queued jobs itself, so nested waits never deadlock. With zero
+// workers everything runs inline on the calling thread.
+// Jobs are a function pointer plus context, so scheduling never allocates.
+class JobSystem {
+public:
+    explicit JobSystem(unsigned workerCount) : queues(workerCount + 1) {
+        for (unsigned i = 0; i < workerCount; i++) {
+            workers.emplace_back([this, i] { workerLoop(i + 1); });
+        }
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Threads that execute jobs, including the caller
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Calls fn(begin, end) over [0, count) split into chunks of at least
+    // minChunk items. Chunk boundaries depend only on count, minChunk and
+    // the thread count, never on timing. Returns when every chunk is done.
+    template <typename F>
+    void parallelFor(size_t count, size_t minChunk, F&& fn) {
+        if (count == 0) return;
+        size_t chunks = std::min<size_t>(threadCount() * 4, (count + minChunk - 1) / minChunk);
+        if (chunks <= 1 || workers.empty()) {
+            fn(size_t(0), count);
+            return;
+        }
+
+        size_t chunkSize = (count + chunks - 1) / chunks;
+        std::atomic<int> pending(static_cast<int>((count + chunkSize - 1) / chunkSize));
+        for (size_t begin = 0; begin < count; begin += chunkSize) {
+            push(Job{&invokeRange<std::remove_reference_t<F>>, &fn, begin, std::min(count, begin + chunkSize), &pending});
+        }
+        wait(pending);
+    }
+
+    // Queues fn(context) to run on any thread; `pending` is decremented when it finishes
+    void submit(void (*fn)(void* context), void* context, std::atomic<int>& pending) {
+        Job job{nullptr, context, 0, 0, &pending, fn};
+        if (workers.empty()) {
+            run(job);
+        } else {
+            push(job);
+        }
+    }
+
+    // Runs queued jobs on the calling thread until `pending` reaches zero
+    void wait(const std::atomic<int>& pending) {
+        while (pending.load(std::memory_order_acquire) > 0) {
+            Job job;
+            if (tryTake(0, job)) {
+                run(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    struct Job {
+        void (*fn)(void* context, size_t begin, size_t end) = nullptr;
+        void* context = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        std::atomic<int>* pending = nullptr;
+        void (*task)(void* context) = nullptr;   // set instead of fn by submit()
+    };
+
+    // Bounded ring of jobs; owner takes from the back, thieves from the front
+    struct WorkQueue {
+        static constexpr size_t CAPACITY = 256;
+        std::mutex mutex;
+        Job jobs[CAPACITY];
+        size_t head = 0;
+        size_t size = 0;
+
+        bool push(const Job& job) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (size == CAPACITY) return false;
+            jobs[(head + size) % CAPACITY] = job;
+            size++;
+            return true;
+        }
+
+        bool popBack(Job& job) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (size == 0) return false;
+            size--;
+            job = jobs[(head + size) % CAPACITY];
+            return true;
+        }
+
+        bool stealFront(Job& job) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (size == 0) return false;
+            job = jobs[head];
+            head = (head + 1) % CAPACITY;
+            size--;
+            return true;
+        }
+    };
+
+    template <typename F>
+    static void invokeRange(void* context, size_t begin, size_t end) {
+        (*static_cast<F*>(context))(begin, end);
+    }
+
+    void push(const Job& job) {
+        size_t start = nextQueue.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < queues.size(); i++) {
+            if (queues[(start + i) % queues.size()].push(job)) {
+                wake.notify_one();
+                return;
+            }
+        }
+        run(job);   // every queue is full: do it now
+    }
+
+    bool tryTake(size_t self, Job& job) {
+        if (queues[self].popBack(job)) return true;
+        for (size_t i = 1; i < queues.size(); i++) {
+            if (queues[(self + i) % queues.size()].stealFront(job)) return true;
+        }
+        return false;
+    }
+
+    static void run(const Job& job) {
+        if (job.task) {
+            job.task(job.context);
+        } else {
+            job.fn(job.context, job.begin, job.end);
+        }
+        job.pending->fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void workerLoop(size_t self) {
+        while (true) {
+            Job job;
+            if (tryTake(self, job)) {
+                run(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            if (stopping) return;
+            wake.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+
+    std::vector<WorkQueue> queues;   // [0] is shared by callers, [1..] by workers
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueue{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+// Fixed dependency graph of stages, built once and run every tick.
+// A stage starts as soon as all stages it depends on have finished; stages
+// with no path between them may run at the same time on different threads.
+class TaskGraph {
+public:
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // Returns the stage id to use in later `dependsOn` lists
+    int add(std::function<void()> fn, std::vector<int> dependsOn = {}) {
+        int id = static_cast<int>(nodes.size());
+        nodes.emplace_back(std::move(fn), static_cast<int>(dependsOn.size()), this);
+        for (int dep : dependsOn) nodes[dep].dependents.push_back(id);
+        return id;
+    }
+
+    void run(JobSystem& jobs) {
+        system = &jobs;
+        remaining.store(static_cast<int>(nodes.size()), std::memory_order_relaxed);
+        for (auto& node : nodes) {
+            node.waitingOn.store(node.dependencyCount, std::memory_order_relaxed);
+        }
+        for (auto& node : nodes) {
+            if (node.dependencyCount == 0) jobs.submit(&runNode, &node, remaining);
+        }
+        jobs.wait(remaining);
+    }
+
+private:
+    struct Node {
+        std::function<void()> fn;
+        std::vector<int> dependents;
+        int dependencyCount;
+        std::atomic<int> waitingOn;
+        TaskGraph* graph;
+
+        Node(std::function<void()> f, int count, TaskGraph* g)
+            : fn(std::move(f)), dependencyCount(count), waitingOn(0), graph(g) {}
+        Node(Node&& other) noexcept
+            : fn(std::move(other.fn)), dependents(std::move(other.dependents)),
+              dependencyCount(other.dependencyCount), waitingOn(0), graph(other.graph) {}
+    };
+
+    static void runNode(void* context) {
+        Node& node = *static_cast<Node*>(context);
+        node.fn();
+        TaskGraph& graph = *node.graph;
+        for (int id : node.dependents) {
+            Node& next = graph.nodes[id];
+            // This node only counts as finished after the submit, so
+            // `remaining` cannot reach zero while stages are still queued
+            if (next.waitingOn.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                graph.system->submit(&runNode, &next, graph.remaining);
+            }
+        }
+    }
+
+    std::vector<Node> nodes;
+    std::atomic<int> remaining{0};
+    JobSystem* system = nullptr;
+};
@@ -0,0 +1,274 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Appends LEB128 varints (zigzag for signed values) to a reused buffer
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void byte(uint8_t value) { out.push_back(value); }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Small magnitudes of either sign take one byte
+    void signedVarint(int64_t value) {
+        varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    size_t size() const { return out.size(); }
+
+private:
+    std::vector<uint8_t>& out;
+};
+
+// Reads what ByteWriter wrote. Reading past the end returns zeros and
+// clears ok(), so a packet can be parsed first and checked once at the end.
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : pos(data), end(data + size) {}
+
+    uint8_t byte() {
+        if (pos == end) {
+            failed = true;
+            return 0;
+        }
+        return *pos++;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t next = byte();
+            value |= static_cast<uint64_t>(next & 0x7F) << shift;
+            if (!(next & 0x80)) return value;
+        }
+        failed = true;
+        return 0;
+    }
+
+    int64_t signedVarint() {
+        uint64_t value = varint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    bool ok() const { return !failed; }
+    bool atEnd() const { return pos == end; }
+    const uint8_t* position() const { return pos; }
+
+private:
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool failed = false;
+};
+
+// One replicated entity, quantised: positions in 1/8 px, velocities in
+// 1/256 px per step. a, b and c carry whatever else the table needs.
+struct NetEntity {
+    static constexpr int FIELDS = 7;   // x, y, vx, vy, a, b, c
+    static constexpr int POSITION_UNITS = 8;
+    static constexpr int VELOCITY_UNITS = 256;
+
+    uint32_t netId;   // table id | generation << 16, unique while the entity lives
+    int32_t field[FIELDS];
+
+    // Where the entity is `steps` later if it keeps its velocity
+    NetEntity extrapolated(int32_t steps) const {
+        NetEntity moved = *this;
+        moved.field[0] += scaledMotion(field[2], steps);
+        moved.field[1] += scaledMotion(field[3], steps);
+        return moved;
+    }
+
+    static int32_t quantise(float value, int units) {
+        return static_cast<int32_t>(value * units + (value < 0 ? -0.5f : 0.5f));
+    }
+
+private:
+    // velocity * steps in position units, rounded the same way on both ends
+    static int32_t scaledMotion(int32_t velocity, int32_t steps) {
+        const int64_t ratio = VELOCITY_UNITS / POSITION_UNITS;
+        int64_t motion = static_cast<int64_t>(velocity) * steps;
+        int64_t rounded = motion >= 0 ? (motion + ratio / 2) / ratio : -((-motion + ratio / 2) / ratio);
+        return static_cast<int32_t>(rounded);
+    }
+};
+
+// The replicated game state at one tick: a few integer scalars and three
+// entity lists sorted by netId.
+//
+// encode() writes it as changes from a baseline the receiver already has,
+// with the baseline's entities moved on by their velocity first, so an
+// entity that just kept moving costs nothing. Per list:
+//   changed/new count, then per entity: netId gap, field mask, and for a
+//   changed entity a zigzag delta per masked field (all fields for a new one)
+//   removed count, then the netId gaps of the removed entities
+// Scalars go as a bit mask of the changed ones followed by their deltas.
+// Without a baseline everything is new, which is the full state.
+struct NetWorld {
+    static constexpr int SCALARS = 16;
+    static constexpr int LISTS = 3;
+    static constexpr uint8_t NEW_ENTITY = 0x80;   // in the field mask
+
+    uint32_t tick = 0;
+    int32_t scalars[SCALARS] = {};
+    std::vector<NetEntity> lists[LISTS];
+
+    // `baseline` (may be null) must be a state the receiver decoded before
+    void encode(ByteWriter& out, const NetWorld* baseline) const {
+        int32_t steps = baseline ? static_cast<int32_t>(tick - baseline->tick) : 0;
+
+        uint32_t changedScalars = 0;
+        for (int i = 0; i < SCALARS; i++) {
+            if (scalars[i] != (baseline ? baseline->scalars[i] : 0)) changedScalars |= 1u << i;
+        }
+        out.varint(changedScalars);
+        for (int i = 0; i < SCALARS; i++) {
+            if (changedScalars & (1u << i)) out.signedVarint(int64_t(scalars[i]) - (baseline ? baseline->scalars[i] : 0));
+        }
+
+        static const std::vector<NetEntity> none;
+        for (int list = 0; list < LISTS; list++) {
+            encodeList(out, lists[list], baseline ? baseline->lists[list] : none, steps);
+        }
+    }
+
+    // Rebuilds the state written by encode() against the same baseline.
+    // `tick` comes from the packet header. False on a malformed packet.
+    bool decode(ByteReader& in, const NetWorld* baseline, uint32_t packetTick) {
+        tick = packetTick;
+        int32_t steps = baseline ? static_cast<int32_t>(tick - baseline->tick) : 0;
+
+        uint64_t changedScalars = in.varint();
+        if (changedScalars >> SCALARS) return false;
+        for (int i = 0; i < SCALARS; i++) {
+            scalars[i] = baseline ? baseline->scalars[i] : 0;
+            if (changedScalars & (1u << i)) scalars[i] += static_cast<int32_t>(in.signedVarint());
+        }
+
+        static const std::vector<NetEntity> none;
+        for (int list = 0; list < LISTS; list++) {
+            if (!decodeList(in, lists[list], baseline ? baseline->lists[list] : none, steps)) return false;
+        }
+        return in.ok();
+    }
+
+    bool operator==(const NetWorld& other) const {
+        if (tick != other.tick || std::memcmp(scalars, other.scalars, sizeof(scalars)) != 0) return false;
+        for (int list = 0; list < LISTS; list++) {
+            if (lists[list].size() != other.lists[list].size()) return false;
+            if (!lists[list].empty() &&
+                std::memcmp(lists[list].data(), other.lists[list].data(), lists[list].size() * sizeof(NetEntity)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static void encodeList(ByteWriter& out, const std::vector<NetEntity>& current, const std::vector<NetEntity>& base,
+                           int32_t steps) {
+        // Changed and new entities; unchanged ones are skipped entirely. The
+        // first pass only counts them, the second writes them.
+        for (int pass = 0; pass < 2; pass++) {
+            uint32_t changed = 0;
+            uint32_t lastId = 0;
+            size_t b = 0;
+            for (const NetEntity& entity : current) {
+                while (b < base.size() && base[b].netId < entity.netId) b++;
+                NetEntity predicted{};
+                uint8_t mask = NEW_ENTITY;
+                if (b < base.size() && base[b].netId == entity.netId) {
+                    predicted = base[b].extrapolated(steps);
+                    mask = 0;
+                    for (int f = 0; f < NetEntity::FIELDS; f++) {
+                        if (entity.field[f] != predicted.field[f]) mask |= static_cast<uint8_t>(1 << f);
+                    }
+                    if (mask == 0) continue;
+                }
+                changed++;
+                if (pass == 0) continue;
+
+                out.varint(entity.netId - lastId);
+                lastId = entity.netId;
+                out.byte(mask);
+                for (int f = 0; f < NetEntity::FIELDS; f++) {
+                    if (mask & NEW_ENTITY) {
+                        out.signedVarint(entity.field[f]);
+                    } else if (mask & (1 << f)) {
+                        out.signedVarint(int64_t(entity.field[f]) - predicted.field[f]);
+                    }
+                }
+            }
+            if (pass == 0) out.varint(changed);
+        }
+
+        // Removed: in the baseline, gone now
+        for (int pass = 0; pass < 2; pass++) {
+            uint32_t removed = 0;
+            uint32_t lastId = 0;
+            size_t c = 0;
+            for (const NetEntity& entity : base) {
+                while (c < current.size() && current[c].netId < entity.netId) c++;
+                if (c < current.size() && current[c].netId == entity.netId) continue;
+                removed++;
+                if (pass == 0) continue;
+                out.varint(entity.netId - lastId);
+                lastId = entity.netId;
+            }
+            if (pass == 0) out.varint(removed);
+        }
+    }
+
+    static bool decodeList(ByteReader& in, std::vector<NetEntity>& current, const std::vector<NetEntity>& base,
+                           int32_t steps) {
+        current.clear();
+        uint64_t changed = in.varint();
+        size_t b = 0;
+        uint32_t id = 0;
+        for (uint64_t i = 0; i < changed && in.ok(); i++) {
+            id += static_cast<uint32_t>(in.varint());
+            uint8_t mask = in.byte();
+            // Baseline entities before this one carry over as predicted
+            while (b < base.size() && base[b].netId < id) current.push_back(base[b++].extrapolated(steps));
+            NetEntity entity{};
+            entity.netId = id;
+            if (mask & NEW_ENTITY) {
+                for (int f = 0; f < NetEntity::FIELDS; f++) entity.field[f] = static_cast<int32_t>(in.signedVarint());
+                if (b < base.size() && base[b].netId == id) b++;
+            } else {
+                if (b == base.size() || base[b].netId != id) return false;   // change to an unknown entity
+                entity = base[b++].extrapolated(steps);
+                for (int f = 0; f < NetEntity::FIELDS; f++) {
+                    if (mask & (1 << f)) entity.field[f] += static_cast<int32_t>(in.signedVarint());
+                }
+            }
+            if (!current.empty() && current.back().netId >= id) return false;
+            current.push_back(entity);
+        }
+        while (b < base.size()) current.push_back(base[b++].extrapolated(steps));
+
+        // Take out the removed ones (both lists are sorted)
+        uint64_t removed = in.varint();
+        size_t keep = 0;
+        size_t scan = 0;
+        id = 0;
+        for (uint64_t i = 0; i < removed && in.ok(); i++) {
+            id += static_cast<uint32_t>(in.varint());
+            while (scan < current.size() && current[scan].netId < id) current[keep++] = current[scan++];
+            if (scan == current.size() || current[scan].netId != id) return false;
+            scan++;
+        }
+        while (scan < current.size()) current[keep++] = current[scan++];
+        current.resize(keep);
+        return in.ok();
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "Rng.hpp"
+
+// A bad network to test against (--latency, --jitter, --loss)
+struct LinkConditions {
+    float latencyMs = 0.0f;     // one way
+    float jitterMs = 0.0f;      // up to this much extra, so packets can arrive out of order
+    float lossPercent = 0.0f;
+};
+
+struct NetAddress {
+    sf::IpAddress ip = sf::IpAddress::LocalHost;
+    unsigned short port = 0;
+
+    bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+};
+
+// Non-blocking UDP socket. Received packets go through LinkConditions:
+// each is dropped with the loss chance or held back for latency + jitter
+// before receive() hands it out. Both ends do this, so the latency applies
+// per direction and a loopback test sees twice it as round trip.
+class NetSocket {
+public:
+    // Port 0 picks a free one (see port())
+    bool bind(unsigned short port) {
+        socket.setBlocking(false);
+        return socket.bind(port) == sf::Socket::Status::Done;
+    }
+
+    unsigned short port() const { return socket.getLocalPort(); }
+
+    void setConditions(const LinkConditions& link, uint32_t seed) {
+        conditions = link;
+        rng.seed(seed, 5);
+    }
+
+    bool send(const std::vector<uint8_t>& packet, const NetAddress& to) {
+        if (socket.send(packet.data(), packet.size(), to.ip, to.port) != sf::Socket::Status::Done) return false;
+        bytesSent += packet.size();
+        packetsSent++;
+        return true;
+    }
+
+    // The next packet due by `nowUs` (inputClockUs() or a test's clock)
+    bool receive(int64_t nowUs, std::vector<uint8_t>& packet, NetAddress& from) {
+        drainSocket(nowUs);
+
+        size_t due = inFlight.size();
+        for (size_t i = 0; i < inFlight.size(); i++) {
+            if (inFlight[i].deliverUs <= nowUs && (due == inFlight.size() || inFlight[i].deliverUs < inFlight[due].deliverUs)) {
+                due = i;
+            }
+        }
+        if (due == inFlight.size()) return false;
+
+        packet.swap(inFlight[due].bytes);
+        from = inFlight[due].from;
+        spare.push_back(std::move(inFlight[due].bytes));   // the caller's old buffer, reused later
+        inFlight[due] = std::move(inFlight.back());
+        inFlight.pop_back();
+        return true;
+    }
+
+    uint64_t bytesSent = 0;
+    uint64_t packetsSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t packetsReceived = 0;
+    uint64_t packetsDropped = 0;   // by the simulated loss
+
+private:
+    struct Delayed {
+        int64_t deliverUs;
+        NetAddress from;
+        std::vector<uint8_t> bytes;
+    };
+
+    void drainSocket(int64_t nowUs) {
+        std::size_t received = 0;
+        std::optional<sf::IpAddress> ip;
+        unsigned short port = 0;
+        while (socket.receive(buffer, sizeof(buffer), received, ip, port) == sf::Socket::Status::Done) {
+            if (!ip) continue;
+            bytesReceived += received;
+            packetsReceived++;
+            if (rng.nextFloat() * 100.0f < conditions.lossPercent) {
+                packetsDropped++;
+                continue;
+            }
+
+            float delayMs = conditions.latencyMs + rng.nextFloat() * conditions.jitterMs;
+            Delayed delayed{nowUs + static_cast<int64_t>(delayMs * 1000.0f), NetAddress{*ip, port}, {}};
+            if (!spare.empty()) {
+                delayed.bytes = std::move(spare.back());
+                spare.pop_back();
+            }
+            delayed.bytes.assign(buffer, buffer + received);
+            inFlight.push_back(std::move(delayed));
+        }
+    }
+
+    sf::UdpSocket socket;
+    LinkConditions conditions;
+    Rng rng;
+    std::vector<Delayed> inFlight;
+    std::vector<std::vector<uint8_t>> spare;
+    uint8_t buffer[sf::UdpSocket::MaxDatagramSize];
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity particle engine with structure-of-arrays storage.
+//
+// Each attribute lives in its own tightly packed array so the integration
+// loop streams through memory and vectorises. Dead particles are removed by
+// moving the last live particle into their slot, so removal is O(1) and the
+// live range is always [0, count). Colours are only interpolated when
+// vertices are generated, never while integrating.
+class ParticleSystem {
+public:
+    explicit ParticleSystem(size_t capacity)
+        : capacity(capacity),
+          x(capacity), y(capacity), vx(capacity), vy(capacity),
+          life(capacity), invMaxLife(capacity), radius(capacity),
+          startColor(capacity), endColor(capacity) {}
+
+    // Velocity is in pixels per simulation step. Returns false when full.
+    bool emit(sf::Vector2f position, sf::Vector2f velocity, float lifetime, float size,
+              sf::Color start, sf::Color end) {
+        if (count == capacity) return false;
+
+        size_t i = count++;
+        x[i] = position.x;
+        y[i] = position.y;
+        vx[i] = velocity.x;
+        vy[i] = velocity.y;
+        life[i] = lifetime;
+        invMaxLife[i] = 1.0f / lifetime;
+        radius[i] = size;
+        startColor[i] = start;
+        endColor[i] = end;
+        return true;
+    }
+
+    // Advances particles [begin, end). Disjoint ranges touch disjoint memory,
+    // so chunks of one step can be integrated on different threads.
+    void integrate(size_t begin, size_t end, float deltaTime) {
+        float* px = x.data();
+        float* py = y.data();
+        float* plife = life.data();
+        const float* pvx = vx.data();
+        const float* pvy = vy.data();
+
+        for (size_t i = begin; i < end; i++) {
+            px[i] += pvx[i];
+            py[i] += pvy[i];
+            plife[i] -= deltaTime;
+        }
+    }
+
+    // Compacts the live range after integrate(); always serial so the
+    // resulting order never depends on how integration was split
+    void removeDead() {
+        for (size_t i = 0; i < count;) {
+            if (life[i] <= 0) {
+                moveLast(i);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    // Writes two triangles per particle into `out`, offset back along the
+    // velocity by (1 - alpha) of a step for render interpolation.
+    // `texRect` is the atlas region stretched over each quad, if any.
+    void buildVertices(sf::VertexArray& out, float alpha, sf::FloatRect texRect = {}) const {
+        out.setPrimitiveType(sf::PrimitiveType::Triangles);
+        out.resize(count * 6);
+
+        float back = alpha - 1.0f;
+        sf::Vector2f t0 = texRect.position;
+        sf::Vector2f t1 = texRect.position + texRect.size;
+
+        for (size_t i = 0; i < count; i++) {
+            float progress = 1.0f - life[i] * invMaxLife[i];
+            sf::Color color = lerp(startColor[i], endColor[i], progress);
+
+            float cx = x[i] + vx[i] * back;
+            float cy = y[i] + vy[i] * back;
+            float d = radius[i] * 2.0f;   // matches CircleShape: position is the top-left corner
+
+            sf::Vertex* v = &out[i * 6];
+            v[0] = sf::Vertex{sf::Vector2f(cx, cy), color, t0};
+            v[1] = sf::Vertex{sf::Vector2f(cx + d, cy), color, sf::Vector2f(t1.x, t0.y)};
+            v[2] = sf::Vertex{sf::Vector2f(cx, cy + d), color, sf::Vector2f(t0.x, t1.y)};
+            v[3] = v[2];
+            v[4] = v[1];
+            v[5] = sf::Vertex{sf::Vector2f(cx + d, cy + d), color, t1};
+        }
+    }
+
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+    size_t maxSize() const { return capacity; }
+
+private:
+    void moveLast(size_t i) {
+        size_t last = --count;
+        x[i] = x[last];
+        y[i] = y[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        life[i] = life[last];
+        invMaxLife[i] = invMaxLife[last];
+        radius[i] = radius[last];
+        startColor[i] = startColor[last];
+        endColor[i] = endColor[last];
+    }
+
+    static sf::Color lerp(sf::Color a, sf::Color b, float t) {
+        return sf::Color(
+            static_cast<uint8_t>(a.r + (b.r - a.r) * t),
+            static_cast<uint8_t>(a.g + (b.g - a.g) * t),
+            static_cast<uint8_t>(a.b + (b.b - a.b) * t),
+            static_cast<uint8_t>(a.a + (b.a - a.a) * t)
+        );
+    }
+
+    size_t capacity;
+    size_t count = 0;
+    std::vector<float> x, y, vx, vy;
+    std::vector<float> life, invMaxLife;
+    std::vector<float> radius;
+    std::vector<sf::Color> startColor, endColor;
+};
@@ -0,0 +1,425 @@
+#pragma once
+
+// Frame profiler.
+//
+// PROFILE_ZONE("name") times the rest of the enclosing scope. Every thread
+// writes its zones into its own ring buffer (no locks, no allocation after
+// the first zone), so the last few thousand frames can be exported as a
+// Chrome trace (chrome://tracing or ui.perfetto.dev). The main thread's
+// top-level zones also feed an on-screen graph of recent frames.
+//
+// Heap allocations are counted too: the executable's operator new calls
+// Profiler::countAllocation(), which charges each one to the innermost
+// zone open on that thread. The overlay shows allocations per frame by
+// zone, and printAllocationReport() totals them for the whole run.
+//
+// Build with -DPROFILER_ENABLED to turn it on. Without it the macros expand
+// to nothing and none of the code below is compiled.
+#ifdef PROFILER_ENABLED
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "BitmapFont.hpp"
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FRAME() Profiler::instance().endFrame()
+
+struct ProfileEvent {
+    const char* name;   // string literal, compared by pointer first
+    uint64_t start;     // ns since the profiler started
+    uint64_t end;
+    uint32_t depth;     // 0 for zones not nested in another zone
+};
+
+class Profiler {
+public:
+    static constexpr size_t RING_CAPACITY = 1 << 15;   // zones kept per thread
+    static constexpr size_t HISTORY = 240;             // frames in the overlay graph
+    static constexpr size_t MAX_LANES = 8;             // top-level zones shown in the graph
+    static constexpr size_t MAX_DEPTH = 32;            // open zones tracked for allocations
+    static constexpr size_t MAX_ALLOC_ZONES = 32;      // zones with their own allocation count
+    static constexpr size_t ALLOC_LINES = 4;           // busiest allocating zones in the overlay
+
+    struct AllocCount {
+        const char* zone = nullptr;
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    // Written by exactly one thread; read by the main thread once the
+    // writers are idle (end of frame, exit)
+    struct ThreadRing {
+        uint32_t threadId = 0;
+        uint32_t depth = 0;
+        const char* open[MAX_DEPTH] = {};          // names of the zones open now, outermost first
+        AllocCount allocs[MAX_ALLOC_ZONES] = {};   // since the last endFrame()
+        std::atomic<uint64_t> written{0};
+        std::unique_ptr<ProfileEvent[]> events{new ProfileEvent[RING_CAPACITY]};
+
+        void push(const ProfileEvent& event) {
+            uint64_t n = written.load(std::memory_order_relaxed);
+            events[n % RING_CAPACITY] = event;
+            written.store(n + 1, std::memory_order_release);
+        }
+    };
+
+    // Charges one heap allocation to the calling thread's innermost zone.
+    // Called from operator new, so it must not allocate: threads that never
+    // opened a zone (and the main thread before its first one) share one
+    // atomic count instead of a ring.
+    static void countAllocation(size_t bytes) {
+        if (ThreadRing* ring = currentRing()) {
+            const char* zone = ring->depth ? ring->open[std::min<size_t>(ring->depth, MAX_DEPTH) - 1] : OUTSIDE_ZONES;
+            addAllocations(ring->allocs, zone, 1, bytes);
+        } else {
+            strayCount.fetch_add(1, std::memory_order_relaxed);
+            strayBytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    uint64_t now() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    // The calling thread's ring, created on its first zone. The first thread
+    // to record anything is the main thread (workers only run inside zones).
+    ThreadRing& threadRing() {
+        ThreadRing*& ring = currentRing();
+        if (!ring) {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(std::make_unique<ThreadRing>());
+            ring = rings.back().get();
+            ring->threadId = static_cast<uint32_t>(rings.size() - 1);
+        }
+        return *ring;
+    }
+
+    // Closes the current frame: sums the main thread's top-level zones into
+    // the overlay history. Call once per frame, from the main thread.
+    void endFrame() {
+        uint64_t frameEnd = now();
+        Frame frame;
+        frame.totalMs = (frameEnd - lastFrameEnd) * 1e-6f;
+        lastFrameEnd = frameEnd;
+
+        ThreadRing& main = threadRing();
+        uint64_t written = main.written.load(std::memory_order_acquire);
+        uint64_t first = std::max(scannedUpTo, written > RING_CAPACITY ? written - RING_CAPACITY : 0);
+        for (uint64_t n = first; n < written; n++) {
+            const ProfileEvent& event = main.events[n % RING_CAPACITY];
+            if (event.depth != 0) continue;
+            int lane = laneOf(event.name);
+            if (lane >= 0) frame.laneMs[lane] += (event.end - event.start) * 1e-6f;
+        }
+        scannedUpTo = written;
+
+        collectAllocations(frame);
+        history[frameCount % HISTORY] = frame;
+        frameCount++;
+        if (frameCount % ALLOC_WINDOW == 0) {
+            std::copy(std::begin(windowAllocs), std::end(windowAllocs), std::begin(shownAllocs));
+            std::fill(std::begin(windowAllocs), std::end(windowAllocs), AllocCount());
+        }
+    }
+
+    // Stacked bar per frame (one colour per top-level zone) plus a legend
+    // with the average of the last second. `font` may be null.
+    void drawOverlay(sf::RenderTarget& target, const BitmapFont* font) {
+        const float graphHeight = 100.0f;
+        const float msToPixels = graphHeight / 33.3f;   // two 60 Hz frames fill the graph
+        AllocCount busiest[ALLOC_LINES];
+        size_t allocLines = busiestAllocations(busiest);
+        sf::Vector2f size(static_cast<float>(HISTORY) + 10, graphHeight + 20 + 14.0f * (laneCount + 1 + allocLines));
+        sf::Vector2f origin(target.getSize().x - size.x - 10, target.getSize().y - size.y - 10);
+
+        sf::VertexArray& quads = overlayQuads;   // kept, so drawing the overlay doesn't allocate
+        quads.clear();
+        addQuad(quads, origin, size, sf::Color(0, 0, 0, 180));
+
+        float baseline = origin.y + 10 + graphHeight;
+        size_t frames = std::min<size_t>(frameCount, HISTORY);
+        for (size_t i = 0; i < frames; i++) {
+            const Frame& frame = history[(frameCount - frames + i) % HISTORY];
+            float x = origin.x + 5 + (HISTORY - frames + i);
+            float y = baseline;
+            for (size_t lane = 0; lane < laneCount; lane++) {
+                float h = std::min(frame.laneMs[lane] * msToPixels, y - (origin.y + 10));
+                y -= h;
+                addQuad(quads, sf::Vector2f(x, y), sf::Vector2f(1, h), laneColor(lane));
+            }
+            // Untracked time (vsync wait, code outside any zone) in grey
+            float rest = std::min(std::max(frame.totalMs * msToPixels - (baseline - y), 0.0f), y - (origin.y + 10));
+            addQuad(quads, sf::Vector2f(x, y - rest), sf::Vector2f(1, rest), sf::Color(80, 80, 80));
+            // Red tick over frames that touched the heap
+            if (frame.allocs > 0) addQuad(quads, sf::Vector2f(x, origin.y + 3), sf::Vector2f(1, 4), sf::Color(255, 60, 60));
+        }
+
+        // 16.7 ms budget line
+        addQuad(quads, sf::Vector2f(origin.x + 5, baseline - 16.7f * msToPixels), sf::Vector2f(HISTORY, 1),
+                sf::Color(255, 255, 255, 120));
+
+        float legendY = baseline + 6;
+        for (size_t lane = 0; lane < laneCount; lane++) {
+            addQuad(quads, sf::Vector2f(origin.x + 5, legendY + 14.0f * lane + 3), sf::Vector2f(8, 8), laneColor(lane));
+        }
+        target.draw(quads);
+
+        if (!font) return;
+        size_t recent = std::min<size_t>(frames, 60);
+        char label[64];
+        for (size_t lane = 0; lane < laneCount; lane++) {
+            float sum = 0;
+            for (size_t i = 0; i < recent; i++) sum += history[(frameCount - 1 - i) % HISTORY].laneMs[lane];
+            snprintf(label, sizeof(label), "%s %.2f ms", laneNames[lane], recent ? sum / recent : 0.0f);
+            drawLabel(target, *font, lane, label, sf::Vector2f(origin.x + 18, legendY + 14.0f * lane));
+        }
+
+        // Heap use over the last second, then the zones doing the most of it
+        uint64_t allocs = 0;
+        uint64_t bytes = 0;
+        for (size_t i = 0; i < recent; i++) {
+            allocs += history[(frameCount - 1 - i) % HISTORY].allocs;
+            bytes += history[(frameCount - 1 - i) % HISTORY].allocBytes;
+        }
+        float allocY = legendY + 14.0f * laneCount;
+        snprintf(label, sizeof(label), "heap %.1f allocs %.1f kb/frame", recent ? double(allocs) / recent : 0.0,
+                 recent ? bytes / 1024.0 / recent : 0.0);
+        drawLabel(target, *font, laneCount, label, sf::Vector2f(origin.x + 5, allocY));
+        for (size_t i = 0; i < allocLines; i++) {
+            snprintf(label, sizeof(label), "%s %.1f/frame", busiest[i].zone, double(busiest[i].count) / ALLOC_WINDOW);
+            drawLabel(target, *font, laneCount + 1 + i, label, sf::Vector2f(origin.x + 18, allocY + 14.0f * (i + 1)));
+        }
+    }
+
+    // Heap allocations by zone since the start. A steady state that doesn't
+    // allocate shows as an early last frame that stays put.
+    void printAllocationReport() const {
+        uint64_t count = 0;
+        for (const AllocCount& entry : totalAllocs) count += entry.count;
+        std::cout << "heap allocations: " << count << " in " << framesWithAllocs << " of " << frameCount
+                  << " frames, last in frame " << lastAllocFrame << "\n";
+
+        AllocCount sorted[MAX_ALLOC_ZONES];
+        std::copy(std::begin(totalAllocs), std::end(totalAllocs), std::begin(sorted));
+        std::sort(std::begin(sorted), std::end(sorted), [](const AllocCount& a, const AllocCount& b) { return a.count > b.count; });
+        for (const AllocCount& entry : sorted) {
+            if (!entry.zone) break;
+            std::cout << "  " << std::left << std::setw(20) << entry.zone << std::right << " " << std::setw(10)
+                      << entry.count << " allocs " << std::setw(12) << entry.bytes << " bytes\n";
+        }
+    }
+
+    // Writes every zone still held in the rings as Chrome trace events.
+    // Call when no other thread is recording (e.g. at exit).
+    bool writeChromeTrace(const std::string& path) {
+        std::ofstream file(path);
+        if (!file) return false;
+
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto& ring : rings) {
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadId
+                 << ",\"args\":{\"name\":\"" << (ring->threadId == 0 ? "main" : "worker") << "\"}}";
+            first = false;
+
+            uint64_t written = ring->written.load(std::memory_order_acquire);
+            uint64_t begin = written > RING_CAPACITY ? written - RING_CAPACITY : 0;
+            for (uint64_t n = begin; n < written; n++) {
+                const ProfileEvent& event = ring->events[n % RING_CAPACITY];
+                char line[256];
+                snprintf(line, sizeof(line),
+                         ",\n{\"name\":\"%s\",\"cat\":\"game\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         event.name, ring->threadId, event.start * 1e-3, (event.end - event.start) * 1e-3);
+                file << line;
+            }
+        }
+        file << "\n]}\n";
+        return static_cast<bool>(file);
+    }
+
+private:
+    struct Frame {
+        float totalMs = 0;
+        float laneMs[MAX_LANES] = {};
+        uint32_t allocs = 0;
+        uint64_t allocBytes = 0;
+    };
+
+    static constexpr size_t ALLOC_WINDOW = 60;   // frames per refresh of the overlay's zone list
+    static constexpr const char* OUTSIDE_ZONES = "(outside zones)";
+    static constexpr const char* OTHER_THREADS = "(startup, other threads)";
+    static constexpr const char* OTHER_ZONES = "(other zones)";
+
+    Profiler() : epoch(std::chrono::steady_clock::now()) {}
+
+    static ThreadRing*& currentRing() {
+        thread_local ThreadRing* ring = nullptr;
+        return ring;
+    }
+
+    // Adds to `zone`'s entry in a MAX_ALLOC_ZONES table; the last entry
+    // takes everything once the table is full
+    static void addAllocations(AllocCount* table, const char* zone, uint64_t count, uint64_t bytes) {
+        size_t i = 0;
+        while (i < MAX_ALLOC_ZONES - 1 && table[i].zone && table[i].zone != zone && std::strcmp(table[i].zone, zone) != 0) i++;
+        if (!table[i].zone) {
+            table[i].zone = zone;
+        } else if (i == MAX_ALLOC_ZONES - 1 && table[i].zone != zone && std::strcmp(table[i].zone, zone) != 0) {
+            table[i].zone = OTHER_ZONES;
+        }
+        table[i].count += count;
+        table[i].bytes += bytes;
+    }
+
+    // Moves every thread's counts since the last frame into `frame` and the
+    // running totals. Same contract as the ring reads: workers are idle.
+    void collectAllocations(Frame& frame) {
+        auto take = [&](const char* zone, uint64_t count, uint64_t bytes) {
+            frame.allocs += static_cast<uint32_t>(count);
+            frame.allocBytes += bytes;
+            addAllocations(windowAllocs, zone, count, bytes);
+            addAllocations(totalAllocs, zone, count, bytes);
+        };
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            for (const auto& ring : rings) {
+                for (AllocCount& entry : ring->allocs) {
+                    if (!entry.zone) break;
+                    take(entry.zone, entry.count, entry.bytes);
+                    entry = AllocCount();
+                }
+            }
+        }
+        uint64_t stray = strayCount.exchange(0, std::memory_order_relaxed);
+        uint64_t strayTotal = strayBytes.exchange(0, std::memory_order_relaxed);
+        if (stray) take(OTHER_THREADS, stray, strayTotal);
+
+        if (frame.allocs > 0) {
+            framesWithAllocs++;
+            lastAllocFrame = static_cast<long long>(frameCount);
+        }
+    }
+
+    // The zones that allocated most over the last full window, busiest first
+    size_t busiestAllocations(AllocCount (&out)[ALLOC_LINES]) const {
+        AllocCount sorted[MAX_ALLOC_ZONES];
+        std::copy(std::begin(shownAllocs), std::end(shownAllocs), std::begin(sorted));
+        std::sort(std::begin(sorted), std::end(sorted), [](const AllocCount& a, const AllocCount& b) { return a.count > b.count; });
+        size_t lines = 0;
+        while (lines < ALLOC_LINES && sorted[lines].zone) {
+            out[lines] = sorted[lines];
+            lines++;
+        }
+        return lines;
+    }
+
+    // Overlay text from a pool of BitmapTexts kept between frames
+    void drawLabel(sf::RenderTarget& target, const BitmapFont& font, size_t index, const char* text, sf::Vector2f position) {
+        while (overlayLabels.size() <= index) overlayLabels.emplace_back(font, "", 11);
+        BitmapText& label = overlayLabels[index];
+        label.setString(text);
+        label.setPosition(position);
+        target.draw(label);
+    }
+
+    // Lane of a top-level zone, assigned in order of first appearance
+    int laneOf(const char* name) {
+        for (size_t i = 0; i < laneCount; i++) {
+            if (laneNames[i] == name || std::strcmp(laneNames[i], name) == 0) return static_cast<int>(i);
+        }
+        if (laneCount == MAX_LANES) return -1;
+        laneNames[laneCount] = name;
+        return static_cast<int>(laneCount++);
+    }
+
+    static sf::Color laneColor(size_t lane) {
+        static const sf::Color palette[MAX_LANES] = {
+            sf::Color(0, 255, 255), sf::Color(255, 0, 255), sf::Color(0, 255, 100), sf::Color(255, 150, 0),
+            sf::Color(255, 255, 0), sf::Color(100, 150, 255), sf::Color(255, 80, 80), sf::Color(200, 200, 200)};
+        return palette[lane % MAX_LANES];
+    }
+
+    static void addQuad(sf::VertexArray& quads, sf::Vector2f position, sf::Vector2f size, sf::Color color) {
+        sf::Vector2f p1 = position + size;
+        quads.append(sf::Vertex{position, color, sf::Vector2f()});
+        quads.append(sf::Vertex{sf::Vector2f(p1.x, position.y), color, sf::Vector2f()});
+        quads.append(sf::Vertex{sf::Vector2f(position.x, p1.y), color, sf::Vector2f()});
+        quads.append(sf::Vertex{sf::Vector2f(position.x, p1.y), color, sf::Vector2f()});
+        quads.append(sf::Vertex{sf::Vector2f(p1.x, position.y), color, sf::Vector2f()});
+        quads.append(sf::Vertex{p1, color, sf::Vector2f()});
+    }
+
+    std::chrono::steady_clock::time_point epoch;
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+
+    Frame history[HISTORY];
+    size_t frameCount = 0;
+    uint64_t lastFrameEnd = 0;
+    uint64_t scannedUpTo = 0;
+    const char* laneNames[MAX_LANES] = {};
+    size_t laneCount = 0;
+
+    sf::VertexArray overlayQuads{sf::PrimitiveType::Triangles};
+    std::vector<BitmapText> overlayLabels;
+
+    inline static std::atomic<uint64_t> strayCount{0};   // see countAllocation()
+    inline static std::atomic<uint64_t> strayBytes{0};
+    AllocCount windowAllocs[MAX_ALLOC_ZONES];   // this ALLOC_WINDOW so far
+    AllocCount shownAllocs[MAX_ALLOC_ZONES];    // the last complete one
+    AllocCount totalAllocs[MAX_ALLOC_ZONES];
+    uint64_t framesWithAllocs = 0;
+    long long lastAllocFrame = -1;
+};
+
+// Records one zone from construction to end of scope
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : ring(Profiler::instance().threadRing()), name(name), start(Profiler::instance().now()) {
+        if (ring.depth < Profiler::MAX_DEPTH) ring.open[ring.depth] = name;
+        ring.depth++;
+    }
+
+    ~ProfileScope() {
+        ring.depth--;
+        ring.push(ProfileEvent{name, start, Profiler::instance().now(), ring.depth});
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler::ThreadRing& ring;
+    const char* name;
+    uint64_t start;
+};
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+
+#endif
@@ -0,0 +1,242 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// SSE2 on any x86-64 build, else plain C++. -DPROJECTILE_SCALAR forces the
+// plain path; both mark exactly the same projectiles.
+#if !defined(PROJECTILE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define PROJECTILE_SSE2
+#endif
+
+// Fixed-capacity engine for enemy projectiles, stored as structure of
+// arrays like ParticleSystem.
+//
+// One pass per step moves every projectile and tests it against at most
+// MAX_TARGETS circles (the players' hitboxes or shields), writing a mark
+// byte per projectile instead of branching out to handle hits. With SSE2
+// it moves 4 at a time and throws out the ones outside a square around
+// every target with plain compares; only the few left get the exact
+// circle test, which is the same scalar code on every path. Chunks of the
+// pass can run on any thread. A serial pass then removes the marked
+// projectiles in index order, so what gets hit never depends on how the
+// work was split.
+//
+// Positions are centres; velocities are in pixels per simulation step.
+class ProjectileSystem {
+public:
+    static constexpr int MAX_TARGETS = 4;
+    static constexpr uint8_t LIVE = 0;       // mark: still flying
+    static constexpr uint8_t OUTSIDE = 0xFF; // mark: left the play area; 1 + target index for a hit
+    static constexpr size_t FLOAT_COLUMNS = 5;   // x, y, vx, vy, radius
+    static constexpr size_t ROW_SIZE = FLOAT_COLUMNS * sizeof(float) + 1;   // bytes per projectile in a snapshot
+
+    // A circle projectiles collide with
+    struct Target {
+        float x, y, radius;
+    };
+
+    // How a style is drawn: its atlas region and where the quad's top-left
+    // corner sits relative to the projectile's centre
+    struct Sprite {
+        sf::FloatRect texRect;
+        sf::Vector2f offset;
+    };
+
+    explicit ProjectileSystem(size_t capacity)
+        : capacity(capacity),
+          x(capacity), y(capacity), vx(capacity), vy(capacity), radius(capacity),
+          style(capacity), mark(capacity) {}
+
+    // Returns false when full
+    bool emit(sf::Vector2f position, sf::Vector2f velocity, float size, uint8_t look) {
+        if (count == capacity) return false;
+
+        size_t i = count++;
+        x[i] = position.x;
+        y[i] = position.y;
+        vx[i] = velocity.x;
+        vy[i] = velocity.y;
+        radius[i] = size;
+        style[i] = look;
+        mark[i] = LIVE;
+        return true;
+    }
+
+    // Moves projectiles [begin, end) one step and marks the ones that now
+    // touch a target (the lowest index wins) or are outside `area`.
+    // Disjoint ranges touch disjoint memory, so chunks of one step can run
+    // on different threads.
+    void integrate(size_t begin, size_t end, const Target* targets, int targetCount, sf::FloatRect area) {
+        float* px = x.data();
+        float* py = y.data();
+        const float* pvx = vx.data();
+        const float* pvy = vy.data();
+        const float* pradius = radius.data();
+        uint8_t* pmark = mark.data();
+        float left = area.position.x;
+        float top = area.position.y;
+        float right = left + area.size.x;
+        float bottom = top + area.size.y;
+
+        size_t i = begin;
+#if defined(PROJECTILE_SSE2)
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        const __m128 vLeft = _mm_set1_ps(left);
+        const __m128 vTop = _mm_set1_ps(top);
+        const __m128 vRight = _mm_set1_ps(right);
+        const __m128 vBottom = _mm_set1_ps(bottom);
+        for (; i + 4 <= end; i += 4) {
+            __m128 cx = _mm_add_ps(_mm_loadu_ps(px + i), _mm_loadu_ps(pvx + i));
+            __m128 cy = _mm_add_ps(_mm_loadu_ps(py + i), _mm_loadu_ps(pvy + i));
+            _mm_storeu_ps(px + i, cx);
+            _mm_storeu_ps(py + i, cy);
+
+            int outside = _mm_movemask_ps(_mm_or_ps(_mm_or_ps(_mm_cmplt_ps(cx, vLeft), _mm_cmpgt_ps(cx, vRight)),
+                                                    _mm_or_ps(_mm_cmplt_ps(cy, vTop), _mm_cmpgt_ps(cy, vBottom))));
+            __m128 r = _mm_loadu_ps(pradius + i);
+            int near = 0;
+            for (int t = 0; t < targetCount; t++) {
+                __m128 reach = _mm_add_ps(r, _mm_set1_ps(targets[t].radius));
+                __m128 dx = _mm_and_ps(_mm_sub_ps(cx, _mm_set1_ps(targets[t].x)), absMask);
+                __m128 dy = _mm_and_ps(_mm_sub_ps(cy, _mm_set1_ps(targets[t].y)), absMask);
+                near |= _mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(dx, reach), _mm_cmplt_ps(dy, reach)));
+            }
+            for (int lane = 0; lane < 4; lane++) {
+                uint8_t m = outside & (1 << lane) ? OUTSIDE : LIVE;
+                if (near & (1 << lane)) m = hitTest(px[i + lane], py[i + lane], pradius[i + lane], targets, targetCount, m);
+                pmark[i + lane] = m;
+            }
+        }
+#endif
+        for (; i < end; i++) {
+            float cx = px[i] + pvx[i];
+            float cy = py[i] + pvy[i];
+            px[i] = cx;
+            py[i] = cy;
+
+            uint8_t m = (cx < left) | (cx > right) | (cy < top) | (cy > bottom) ? OUTSIDE : LIVE;
+            pmark[i] = hitTest(cx, cy, pradius[i], targets, targetCount, m);
+        }
+    }
+
+    // Removes everything integrate() marked; always serial. `hit(target,
+    // position)` is called for each projectile that touched a target, in
+    // index order, before it goes.
+    template <typename OnHit>
+    void removeMarked(OnHit&& hit) {
+        for (size_t i = 0; i < count;) {
+            uint8_t m = mark[i];
+            if (m == LIVE) {
+                i++;
+                continue;
+            }
+            if (m != OUTSIDE) hit(m - 1, sf::Vector2f(x[i], y[i]));
+            moveLast(i);
+        }
+    }
+
+    // Writes two triangles per projectile into `out`, offset back along the
+    // velocity by (1 - alpha) of a step for render interpolation.
+    // `sprites` is indexed by style.
+    void buildVertices(sf::VertexArray& out, float alpha, const Sprite* sprites) const {
+        out.setPrimitiveType(sf::PrimitiveType::Triangles);
+        out.resize(count * 6);
+
+        float back = alpha - 1.0f;
+        for (size_t i = 0; i < count; i++) {
+            const Sprite& sprite = sprites[style[i]];
+            sf::Vector2f t0 = sprite.texRect.position;
+            sf::Vector2f t1 = sprite.texRect.position + sprite.texRect.size;
+            float cx = x[i] + vx[i] * back + sprite.offset.x;
+            float cy = y[i] + vy[i] * back + sprite.offset.y;
+            float w = sprite.texRect.size.x;
+            float h = sprite.texRect.size.y;
+
+            sf::Vertex* v = &out[i * 6];
+            v[0] = sf::Vertex{sf::Vector2f(cx, cy), sf::Color::White, t0};
+            v[1] = sf::Vertex{sf::Vector2f(cx + w, cy), sf::Color::White, sf::Vector2f(t1.x, t0.y)};
+            v[2] = sf::Vertex{sf::Vector2f(cx, cy + h), sf::Color::White, sf::Vector2f(t0.x, t1.y)};
+            v[3] = v[2];
+            v[4] = v[1];
+            v[5] = sf::Vertex{sf::Vector2f(cx + w, cy + h), sf::Color::White, t1};
+        }
+    }
+
+    // Snapshots: the live projectiles as raw bytes, array by array
+    size_t rowBytes() const { return count * ROW_SIZE; }
+
+    // Writes rowBytes() bytes to `out` and returns the end
+    uint8_t* writeRows(uint8_t* out) const {
+        for (const std::vector<float>* column : {&x, &y, &vx, &vy, &radius}) {
+            std::memcpy(out, column->data(), count * sizeof(float));
+            out += count * sizeof(float);
+        }
+        std::memcpy(out, style.data(), count);
+        return out + count;
+    }
+
+    // Where the style bytes start in `rows` projectiles written by
+    // writeRows(), so a snapshot can be checked before it is restored
+    static const uint8_t* stylesIn(const uint8_t* in, size_t rows) { return in + rows * FLOAT_COLUMNS * sizeof(float); }
+
+    // Replaces the contents with `rows` projectiles as written by
+    // writeRows(). Returns false (and leaves it empty) if they don't fit.
+    bool readRows(const uint8_t* in, size_t rows) {
+        if (rows > capacity) {
+            count = 0;
+            return false;
+        }
+        count = rows;
+        for (std::vector<float>* column : {&x, &y, &vx, &vy, &radius}) {
+            std::memcpy(column->data(), in, count * sizeof(float));
+            in += count * sizeof(float);
+        }
+        std::memcpy(style.data(), in, count);
+        std::fill(mark.begin(), mark.begin() + count, LIVE);
+        return true;
+    }
+
+    sf::Vector2f position(size_t i) const { return sf::Vector2f(x[i], y[i]); }
+    sf::Vector2f velocity(size_t i) const { return sf::Vector2f(vx[i], vy[i]); }
+    float radiusOf(size_t i) const { return radius[i]; }
+
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+    size_t maxSize() const { return capacity; }
+
+private:
+    // The mark for a projectile at (cx, cy): 1 + the lowest target it
+    // touches, else `otherwise`. Anything that fails the square reject
+    // fails this too, so the SSE2 path can skip it.
+    static uint8_t hitTest(float cx, float cy, float size, const Target* targets, int targetCount, uint8_t otherwise) {
+        for (int t = 0; t < targetCount; t++) {
+            float dx = cx - targets[t].x;
+            float dy = cy - targets[t].y;
+            float reach = size + targets[t].radius;
+            if (dx * dx + dy * dy < reach * reach) return static_cast<uint8_t>(t + 1);
+        }
+        return otherwise;
+    }
+
+    void moveLast(size_t i) {
+        size_t last = --count;
+        x[i] = x[last];
+        y[i] = y[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        radius[i] = radius[last];
+        style[i] = style[last];
+        mark[i] = mark[last];
+    }
+
+    size_t capacity;
+    size_t count = 0;
+    std::vector<float> x, y, vx, vy;
+    std::vector<float> radius;
+    std::vector<uint8_t> style;
+    std::vector<uint8_t> mark;   // written by integrate(), read by removeMarked()
+};
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Input replay: the RNG seed plus one byte of input bits per simulation step.
+//
+// File layout (all integers are LEB128 varints unless noted):
+//   "NSAR" version seed tickCount hashInterval
+//   runs of (input byte, run length) covering tickCount steps
+//   checkpointCount, then checkpointCount little-endian uint32 state hashes
+//
+// Held keys produce long runs, so a minute of play is typically a few hundred
+// bytes. A state hash is kept every hashInterval steps so playback can tell
+// where a run diverged without storing the state itself. VERSION changes
+// whenever the hash covers different state, so an older recording is refused
+// instead of reporting a divergence that never happened.
+struct Replay {
+    static constexpr uint8_t VERSION = 2;
+
+    uint32_t seed = 0;
+    uint32_t hashInterval = 60;
+    std::vector<uint8_t> inputs;         // one entry per step
+    std::vector<uint32_t> checkpoints;   // state hash after every hashInterval-th step
+
+    // Records one step; call after the step has been simulated
+    void record(uint8_t inputBits, uint32_t stateHash) {
+        inputs.push_back(inputBits);
+        if (inputs.size() % hashInterval == 0) {
+            checkpoints.push_back(stateHash);
+        }
+    }
+
+    // Forgets every step after the first `steps` (e.g. after a rewind)
+    void truncate(size_t steps) {
+        if (steps >= inputs.size()) return;
+        inputs.resize(steps);
+        checkpoints.resize(steps / hashInterval);
+    }
+
+    // Returns false when the hash after `tick` (0-based) disagrees with the recording
+    bool verify(size_t tick, uint32_t stateHash) const {
+        size_t steps = tick + 1;
+        if (steps % hashInterval != 0) return true;
+        size_t index = steps / hashInterval - 1;
+        return index >= checkpoints.size() || checkpoints[index] == stateHash;
+    }
+
+    bool save(const std::string& path) const {
+        std::vector<uint8_t> out = {'N', 'S', 'A', 'R', VERSION};
+        writeVarint(out, seed);
+        writeVarint(out, inputs.size());
+        writeVarint(out, hashInterval);
+
+        for (size_t i = 0; i < inputs.size();) {
+            size_t run = 1;
+            while (i + run < inputs.size() && inputs[i + run] == inputs[i]) run++;
+            out.push_back(inputs[i]);
+            writeVarint(out, run);
+            i += run;
+        }
+
+        writeVarint(out, checkpoints.size());
+        for (uint32_t hash : checkpoints) {
+            for (int b = 0; b < 4; b++) out.push_back(static_cast<uint8_t>(hash >> (8 * b)));
+        }
+
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+        return static_cast<bool>(file);
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<uint8_t> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (in.size() < 5 || std::memcmp(in.data(), "NSAR", 4) != 0 || in[4] != VERSION) return false;
+
+        size_t pos = 5;
+        uint64_t tickCount = 0, interval = 0, checkpointCount = 0;
+        uint64_t seedValue = 0;
+        if (!readVarint(in, pos, seedValue) || !readVarint(in, pos, tickCount) ||
+            !readVarint(in, pos, interval) || interval == 0) {
+            return false;
+        }
+        seed = static_cast<uint32_t>(seedValue);
+        hashInterval = static_cast<uint32_t>(interval);
+
+        inputs.clear();
+        while (inputs.size() < tickCount) {
+            uint64_t run = 0;
+            if (pos >= in.size()) return false;
+            uint8_t bits = in[pos++];
+            if (!readVarint(in, pos, run) || run == 0 || inputs.size() + run > tickCount) return false;
+            inputs.insert(inputs.end(), static_cast<size_t>(run), bits);
+        }
+
+        if (!readVarint(in, pos, checkpointCount) || in.size() - pos < checkpointCount * 4) return false;
+        checkpoints.resize(static_cast<size_t>(checkpointCount));
+        for (uint32_t& hash : checkpoints) {
+            hash = in[pos] | (in[pos + 1] << 8) | (in[pos + 2] << 16) | (static_cast<uint32_t>(in[pos + 3]) << 24);
+            pos += 4;
+        }
+        return true;
+    }
+
+private:
+    static void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static bool readVarint(const std::vector<uint8_t>& in, size_t& pos, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+            uint8_t byte = in[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+};
+
+// FNV-1a accumulator used for the per-step state hash
+struct StateHash {
+    uint32_t value = 2166136261u;
+
+    void add(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            value = (value ^ bytes[i]) * 16777619u;
+        }
+    }
+
+    template <typename T>
+    void add(const T& pod) { add(&pod, sizeof(T)); }
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+// PCG32 random number generator.
+// Each subsystem owns its own stream, so drawing extra particles never
+// changes which enemy spawns next and a run is reproducible from one seed.
+class Rng {
+public:
+    Rng() { seed(0, 0); }
+    Rng(uint64_t seedValue, uint64_t stream) { seed(seedValue, stream); }
+
+    void seed(uint64_t seedValue, uint64_t stream) {
+        state = 0;
+        increment = (stream << 1u) | 1u;
+        next();
+        state += seedValue;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t xorShifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorShifted >> rot) | (xorShifted << ((32u - rot) & 31u));
+    }
+
+    // Uniform integer in [0, n)
+    int nextInt(int n) {
+        return static_cast<int>((static_cast<uint64_t>(next()) * static_cast<uint32_t>(n)) >> 32);
+    }
+
+    // Uniform float in [0, 1)
+    float nextFloat() {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    uint64_t state;
+    uint64_t increment;
+};
@@ -0,0 +1,158 @@
+#pragma once
+#include <SFML/System.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "Rng.hpp"
+
+// Gameplay state outside the entity tables, copied as bytes
+struct SnapshotState {
+    uint64_t stepCount;
+    uint32_t seed;
+    Rng spawnRng, lootRng, starRng, fxRng;
+
+    int32_t score, lives, combo;
+    int32_t currentLevel, enemiesKilledInLevel, enemiesNeededForNextLevel;
+    int32_t archetypeCount;   // sanity check against the loaded wave file
+    float comboTimer;
+    float baseEnemySpeed, spawnInterval, spawnTimer, powerUpSpawnTimer;
+    float rapidFireTimer, shieldTimer, tripleShotTimer;
+    float levelTransitionTimer, screenShake;
+    float patternCooldown;
+    int32_t patternStep;
+    sf::Vector2f shakeOffset;
+    int32_t playerCount;
+    sf::Vector2f rocketPositions[2];   // MAX_PLAYERS
+    float shootCooldowns[2];
+    uint8_t gameOver, levelTransition, rapidFire, hasShield, hasTripleShot;
+
+    uint32_t bossRow;   // UINT32_MAX without a boss
+    uint32_t enemyCount, bulletCount, powerUpCount, projectileCount;
+};
+
+static_assert(std::is_trivially_copyable<SnapshotState>::value, "snapshots are copied as bytes");
+
+// The whole simulation at a step boundary, as one flat byte buffer.
+//
+// Layout: "NSAS" version, SnapshotState, then the enemy, bullet and
+// power-up rows (EntityTable::writeRows) and the enemy projectiles
+// (ProjectileSystem::writeRows). Taking one is a handful of memcpys into
+// a buffer that is reused, so it costs microseconds and allocates nothing
+// once the buffer has grown. Particles and stars are cosmetic and not
+// included.
+//
+// Files hold the same bytes, so they only load into a build with the same
+// struct layouts; VERSION changes whenever those do.
+struct Snapshot {
+    static constexpr uint8_t VERSION = 3;
+    static constexpr size_t HEADER_SIZE = 8;   // magic, version, padding
+
+    std::vector<uint8_t> bytes;
+
+    bool empty() const { return bytes.empty(); }
+
+    const SnapshotState* state() const {
+        if (bytes.size() < HEADER_SIZE + sizeof(SnapshotState)) return nullptr;
+        if (std::memcmp(bytes.data(), "NSAS", 4) != 0 || bytes[4] != VERSION) return nullptr;
+        return reinterpret_cast<const SnapshotState*>(bytes.data() + HEADER_SIZE);
+    }
+
+    const uint8_t* rows() const { return bytes.data() + HEADER_SIZE + sizeof(SnapshotState); }
+    size_t rowBytes() const { return bytes.size() - HEADER_SIZE - sizeof(SnapshotState); }
+
+    // Sizes the buffer for `rowBytes` of rows and writes the header
+    SnapshotState& begin(size_t rowBytes) {
+        bytes.resize(HEADER_SIZE + sizeof(SnapshotState) + rowBytes);
+        std::memcpy(bytes.data(), "NSAS", 4);
+        bytes[4] = VERSION;
+        bytes[5] = bytes[6] = bytes[7] = 0;
+        return *reinterpret_cast<SnapshotState*>(bytes.data() + HEADER_SIZE);
+    }
+
+    uint8_t* rowsOut() { return bytes.data() + HEADER_SIZE + sizeof(SnapshotState); }
+
+    // Goes through a temporary file, so a crash mid-write keeps the old one
+    bool save(const std::string& path) const {
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            if (!file) return false;
+        }
+#ifdef _WIN32
+        std::remove(path.c_str());   // rename() won't replace a file here
+#endif
+        return std::rename(temp.c_str(), path.c_str()) == 0;
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return state() != nullptr;
+    }
+};
+
+// Writes snapshots to one file on its own thread, so the game never waits
+// for the disk. Only the newest snapshot not yet written is kept; the
+// destructor writes that one before returning.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path) : path(path), thread([this] { writeLoop(); }) {}
+
+    ~SnapshotWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    // Copies `snapshot` (into a buffer kept between calls) and returns
+    void submit(const Snapshot& snapshot) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.bytes = snapshot.bytes;
+            hasPending = true;
+        }
+        wake.notify_one();
+    }
+
+private:
+    void writeLoop() {
+        Snapshot writing;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return hasPending || stopping; });
+            if (hasPending) {
+                std::swap(writing.bytes, pending.bytes);
+                hasPending = false;
+                lock.unlock();
+                if (!writing.save(path)) std::fprintf(stderr, "could not write save %s\n", path.c_str());
+                lock.lock();
+            } else {
+                return;
+            }
+        }
+    }
+
+    std::string path;
+    std::mutex mutex;
+    std::condition_variable wake;
+    Snapshot pending;
+    bool hasPending = false;
+    bool stopping = false;
+    std::thread thread;   // last, so everything it uses exists before it starts
+};
@@ -0,0 +1,448 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Span blending 4 pixels at a time with SSE2 on any x86-64 build, else
+// plain C++. -DCANVAS_SCALAR forces the plain path. Both do the same
+// integer maths, so a frame comes out byte for byte the same on either.
+#if !defined(CANVAS_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define CANVAS_SSE2
+#endif
+
+// RGBA pixels in memory (the byte order sf::Image uses) with a small CPU
+// rasteriser, so frames can be drawn where there is no GL context.
+//
+// It draws what the GPU path sends to a window: sf::Vertex triangle lists
+// sampled from another canvas (nearest texel, like the unsmoothed atlas
+// textures), and sf::Shape fills and outlines tessellated the way SFML
+// does it. Quads from SpriteBatch, glyphs and particles are axis aligned
+// and take a row-at-a-time path; ribbons and shape triangles are filled
+// span by span. Pixels are covered when their centre is, as on the GPU.
+//
+// Blending follows SFML's modes on straight (not premultiplied) alpha.
+class SoftwareCanvas {
+public:
+    enum class Blend { None, Alpha, Add };   // sf::BlendNone, sf::BlendAlpha, sf::BlendAdd
+
+    SoftwareCanvas() = default;
+    SoftwareCanvas(unsigned width, unsigned height) { create(width, height); }
+
+    void create(unsigned width, unsigned height, sf::Color color = sf::Color::Transparent) {
+        w = static_cast<int>(width);
+        h = static_cast<int>(height);
+        pixels.resize(static_cast<size_t>(w) * h * 4);
+        span.resize(static_cast<size_t>(w) * 4);
+        columns.resize(static_cast<size_t>(w));
+        clear(color);
+    }
+
+    // Takes a copy of `rgba` (width * height * 4 bytes)
+    void assign(unsigned width, unsigned height, const uint8_t* rgba) {
+        create(width, height);
+        std::memcpy(pixels.data(), rgba, pixels.size());
+    }
+
+    unsigned width() const { return static_cast<unsigned>(w); }
+    unsigned height() const { return static_cast<unsigned>(h); }
+    sf::Vector2u size() const { return sf::Vector2u(width(), height()); }
+    const uint8_t* data() const { return pixels.data(); }
+
+    sf::Color pixel(unsigned x, unsigned y) const {
+        const uint8_t* p = &pixels[(static_cast<size_t>(y) * w + x) * 4];
+        return sf::Color(p[0], p[1], p[2], p[3]);
+    }
+
+    void clear(sf::Color color) {
+        if (h == 0) return;
+        fillSpan(row(0), w, color);
+        for (int y = 1; y < h; y++) std::memcpy(row(y), row(0), static_cast<size_t>(w) * 4);
+    }
+
+    // Triangle list, moved by `offset`; `texture` may be null (plain white)
+    void drawTriangles(const sf::Vertex* vertices, size_t count, const SoftwareCanvas* texture, sf::Vector2f offset,
+                       Blend blend = Blend::Alpha) {
+        size_t i = 0;
+        while (i + 3 <= count) {
+            if (i + 6 <= count && isQuad(vertices + i)) {
+                const sf::Vertex* q = vertices + i;
+                drawQuad(q[0].position + offset, q[5].position + offset, q[0].texCoords, q[5].texCoords, q[0].color,
+                         texture, blend);
+                i += 6;
+            } else {
+                drawTriangle(vertices[i], vertices[i + 1], vertices[i + 2], texture, offset, blend);
+                i += 3;
+            }
+        }
+    }
+
+    void drawTriangles(const sf::VertexArray& vertices, const SoftwareCanvas* texture, sf::Vector2f offset,
+                       Blend blend = Blend::Alpha) {
+        if (vertices.getVertexCount() == 0) return;
+        drawTriangles(&vertices[0], vertices.getVertexCount(), texture, offset, blend);
+    }
+
+    // Fill as a fan from the centre of the points' bounds, then the outline
+    // as a strip pushed out along the mitred normals (sf::Shape::update)
+    void drawShape(const sf::Shape& shape, sf::Vector2f offset, Blend blend = Blend::Alpha) {
+        size_t count = shape.getPointCount();
+        if (count < 3) return;
+        sf::Transform transform = shape.getTransform();
+
+        sf::Vector2f low = shape.getPoint(0);
+        sf::Vector2f high = low;
+        for (size_t i = 1; i < count; i++) {
+            sf::Vector2f p = shape.getPoint(i);
+            low = sf::Vector2f(std::min(low.x, p.x), std::min(low.y, p.y));
+            high = sf::Vector2f(std::max(high.x, p.x), std::max(high.y, p.y));
+        }
+        sf::Vector2f center = (low + high) * 0.5f;
+
+        sf::Vertex hub{transform.transformPoint(center) + offset, shape.getFillColor(), {}};
+        for (size_t i = 0; i < count; i++) {
+            sf::Vertex a{transform.transformPoint(shape.getPoint(i)) + offset, shape.getFillColor(), {}};
+            sf::Vertex b{transform.transformPoint(shape.getPoint((i + 1) % count)) + offset, shape.getFillColor(), {}};
+            drawTriangle(hub, a, b, nullptr, sf::Vector2f(0, 0), blend);
+        }
+
+        float thickness = shape.getOutlineThickness();
+        if (thickness == 0) return;
+        sf::Vertex inner[2];
+        sf::Vertex outer[2];
+        for (size_t i = 0; i <= count; i++) {
+            sf::Vector2f p0 = shape.getPoint((i + count - 1) % count);
+            sf::Vector2f p1 = shape.getPoint(i % count);
+            sf::Vector2f p2 = shape.getPoint((i + 1) % count);
+            sf::Vector2f n1 = outward(p0, p1, center);
+            sf::Vector2f n2 = outward(p1, p2, center);
+            float factor = 1.0f + (n1.x * n2.x + n1.y * n2.y);
+            sf::Vector2f normal = (n1 + n2) / factor;
+
+            inner[1] = sf::Vertex{transform.transformPoint(p1) + offset, shape.getOutlineColor(), {}};
+            outer[1] = sf::Vertex{transform.transformPoint(p1 + normal * thickness) + offset, shape.getOutlineColor(), {}};
+            if (i > 0) {
+                drawTriangle(inner[0], outer[0], inner[1], nullptr, sf::Vector2f(0, 0), blend);
+                drawTriangle(outer[0], inner[1], outer[1], nullptr, sf::Vector2f(0, 0), blend);
+            }
+            inner[0] = inner[1];
+            outer[0] = outer[1];
+        }
+    }
+
+    // Copies `source` at `position`, like drawing it as a sprite
+    void drawCanvas(const SoftwareCanvas& source, sf::Vector2f position, Blend blend = Blend::Alpha) {
+        sf::Vector2f size(static_cast<float>(source.w), static_cast<float>(source.h));
+        drawQuad(position, position + size, sf::Vector2f(0, 0), size, sf::Color::White, &source, blend);
+    }
+
+    // Through sf::Image, so any format it knows (PNG for goldens)
+    bool saveToFile(const std::string& path) const {
+        sf::Image image(size(), pixels.data());
+        return image.saveToFile(path);
+    }
+
+    bool loadFromFile(const std::string& path) {
+        sf::Image image;
+        if (!image.loadFromFile(path)) return false;
+        assign(image.getSize().x, image.getSize().y, image.getPixelsPtr());
+        return true;
+    }
+
+    // Pixels where some channel differs by more than `tolerance`; all of
+    // them if the sizes differ
+    size_t differingPixels(const SoftwareCanvas& other, int tolerance) const {
+        if (w != other.w || h != other.h) return static_cast<size_t>(std::max(w * h, other.w * other.h));
+        size_t differing = 0;
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            for (size_t c = 0; c < 4; c++) {
+                if (std::abs(int(pixels[i + c]) - int(other.pixels[i + c])) > tolerance) {
+                    differing++;
+                    break;
+                }
+            }
+        }
+        return differing;
+    }
+
+private:
+    // x / 255 rounded, exact for anything two 8-bit products add up to
+    static uint32_t div255(uint32_t x) {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    // The six vertices SpriteBatch::addQuad (and the glyph and particle
+    // builders) write: corners 0 and 5, with 1 and 2 on the other corners
+    // and repeated as 4 and 3, one colour
+    static bool isQuad(const sf::Vertex* v) {
+        return v[3].position == v[2].position && v[4].position == v[1].position &&
+               v[1].position.y == v[0].position.y && v[2].position.x == v[0].position.x &&
+               v[5].position.x == v[1].position.x && v[5].position.y == v[2].position.y &&
+               v[3].texCoords == v[2].texCoords && v[4].texCoords == v[1].texCoords &&
+               v[1].texCoords == sf::Vector2f(v[5].texCoords.x, v[0].texCoords.y) &&
+               v[2].texCoords == sf::Vector2f(v[0].texCoords.x, v[5].texCoords.y) &&
+               v[1].color == v[0].color && v[2].color == v[0].color && v[3].color == v[0].color &&
+               v[4].color == v[0].color && v[5].color == v[0].color;
+    }
+
+    static sf::Vector2f outward(sf::Vector2f from, sf::Vector2f to, sf::Vector2f center) {
+        sf::Vector2f normal(from.y - to.y, to.x - from.x);
+        float length = std::sqrt(normal.x * normal.x + normal.y * normal.y);
+        if (length != 0) normal = normal / length;
+        if (normal.x * (center.x - to.x) + normal.y * (center.y - to.y) > 0) normal = -normal;
+        return normal;
+    }
+
+    // First pixel whose centre is at or right of (below) `edge`
+    static int firstCovered(float edge) { return static_cast<int>(std::ceil(edge - 0.5f)); }
+
+    // Axis aligned, one colour: texel columns are worked out once, then each
+    // row is gathered, tinted and blended
+    void drawQuad(sf::Vector2f p0, sf::Vector2f p1, sf::Vector2f t0, sf::Vector2f t1, sf::Color color,
+                  const SoftwareCanvas* texture, Blend blend) {
+        if (p1.x < p0.x) {
+            std::swap(p0.x, p1.x);
+            std::swap(t0.x, t1.x);
+        }
+        if (p1.y < p0.y) {
+            std::swap(p0.y, p1.y);
+            std::swap(t0.y, t1.y);
+        }
+        int x0 = std::max(firstCovered(p0.x), 0);
+        int x1 = std::min(firstCovered(p1.x), w);
+        int y0 = std::max(firstCovered(p0.y), 0);
+        int y1 = std::min(firstCovered(p1.y), h);
+        if (x0 >= x1 || y0 >= y1) return;
+        int count = x1 - x0;
+
+        if (!texture) {
+            fillSpan(span.data(), count, color);
+            for (int y = y0; y < y1; y++) blendSpan(row(y) + x0 * 4, span.data(), count, blend);
+            return;
+        }
+
+        float du = (t1.x - t0.x) / (p1.x - p0.x);
+        float dv = (t1.y - t0.y) / (p1.y - p0.y);
+        for (int x = x0; x < x1; x++) {
+            columns[x - x0] = texelIndex(t0.x + (x + 0.5f - p0.x) * du, texture->w) * 4;
+        }
+        bool tinted = color != sf::Color::White;
+        for (int y = y0; y < y1; y++) {
+            const uint8_t* source = texture->row(texelIndex(t0.y + (y + 0.5f - p0.y) * dv, texture->h));
+            for (int i = 0; i < count; i++) std::memcpy(&span[i * 4], source + columns[i], 4);
+            if (tinted) modulateSpan(span.data(), count, color);
+            blendSpan(row(y) + x0 * 4, span.data(), count, blend);
+        }
+    }
+
+    // Any triangle, scanline by scanline. Colour and texture coordinates are
+    // interpolated across it unless they are the same at every corner.
+    void drawTriangle(sf::Vertex a, sf::Vertex b, sf::Vertex c, const SoftwareCanvas* texture, sf::Vector2f offset,
+                      Blend blend) {
+        a.position += offset;
+        b.position += offset;
+        c.position += offset;
+
+        // Sorted top to bottom, so a and c span every row
+        if (b.position.y < a.position.y) std::swap(a, b);
+        if (c.position.y < a.position.y) std::swap(a, c);
+        if (c.position.y < b.position.y) std::swap(b, c);
+        float area = (b.position.x - a.position.x) * (c.position.y - a.position.y) -
+                     (c.position.x - a.position.x) * (b.position.y - a.position.y);
+        int y0 = std::max(firstCovered(a.position.y), 0);
+        int y1 = std::min(firstCovered(c.position.y), h);
+        if (area == 0 || y0 >= y1) return;
+
+        // One texel for the whole triangle (ribbons sample the solid block)
+        bool oneTexel = a.texCoords == b.texCoords && a.texCoords == c.texCoords;
+        sf::Color texelColor = texture && oneTexel ? texel(*texture, a.texCoords) : sf::Color::White;
+        bool flat = a.color == b.color && a.color == c.color && (!texture || oneTexel);
+        if (flat) {
+            sf::Color color = modulate(texelColor, a.color);
+            float left = std::min({a.position.x, b.position.x, c.position.x});
+            float right = std::max({a.position.x, b.position.x, c.position.x});
+            fillSpan(span.data(), std::min(static_cast<int>(right - left) + 2, w), color);
+        }
+
+        // Attribute planes: value = base + x * dx + y * dy, for r g b a u v
+        float values[3][6];
+        const sf::Vertex* corners[3] = {&a, &b, &c};
+        for (int k = 0; k < 3; k++) {
+            const sf::Vertex& v = *corners[k];
+            float corner[6] = {float(v.color.r), float(v.color.g), float(v.color.b), float(v.color.a), v.texCoords.x, v.texCoords.y};
+            std::memcpy(values[k], corner, sizeof(corner));
+        }
+        float dx[6], dy[6], base[6];
+        for (int f = 0; f < 6; f++) {
+            float db = values[1][f] - values[0][f];
+            float dc = values[2][f] - values[0][f];
+            dx[f] = (db * (c.position.y - a.position.y) - dc * (b.position.y - a.position.y)) / area;
+            dy[f] = (dc * (b.position.x - a.position.x) - db * (c.position.x - a.position.x)) / area;
+            base[f] = values[0][f] - a.position.x * dx[f] - a.position.y * dy[f];
+        }
+
+        for (int y = y0; y < y1; y++) {
+            float centerY = y + 0.5f;
+            float xa = edgeX(a.position, c.position, centerY);
+            float xb = centerY < b.position.y ? edgeX(a.position, b.position, centerY) : edgeX(b.position, c.position, centerY);
+            int x0 = std::max(firstCovered(std::min(xa, xb)), 0);
+            int x1 = std::min(firstCovered(std::max(xa, xb)), w);
+            if (x0 >= x1) continue;
+
+            if (!flat) {
+                float at[6];
+                for (int f = 0; f < 6; f++) at[f] = base[f] + (x0 + 0.5f) * dx[f] + centerY * dy[f];
+                for (int x = x0; x < x1; x++) {
+                    sf::Color color(channel(at[0]), channel(at[1]), channel(at[2]), channel(at[3]));
+                    if (texture && !oneTexel) color = modulate(texel(*texture, sf::Vector2f(at[4], at[5])), color);
+                    uint8_t* out = &span[(x - x0) * 4];
+                    out[0] = color.r;
+                    out[1] = color.g;
+                    out[2] = color.b;
+                    out[3] = color.a;
+                    for (int f = 0; f < 6; f++) at[f] += dx[f];
+                }
+                if (texelColor != sf::Color::White) modulateSpan(span.data(), x1 - x0, texelColor);
+            }
+            blendSpan(row(y) + x0 * 4, span.data(), x1 - x0, blend);
+        }
+    }
+
+    // Where the edge crosses the row. Endpoints go in a fixed order, so two
+    // triangles sharing the edge get the same x and neither gaps nor overlaps.
+    static float edgeX(sf::Vector2f p, sf::Vector2f q, float y) {
+        if (q.y < p.y || (q.y == p.y && q.x < p.x)) std::swap(p, q);
+        if (q.y == p.y) return p.x;
+        return p.x + (y - p.y) * (q.x - p.x) / (q.y - p.y);
+    }
+
+    static uint8_t channel(float value) {
+        return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, value + 0.5f)));
+    }
+
+    static int texelIndex(float coordinate, int size) {
+        return std::min(std::max(static_cast<int>(std::floor(coordinate)), 0), size - 1);
+    }
+
+    static sf::Color texel(const SoftwareCanvas& texture, sf::Vector2f coords) {
+        return texture.pixel(static_cast<unsigned>(texelIndex(coords.x, texture.w)),
+                             static_cast<unsigned>(texelIndex(coords.y, texture.h)));
+    }
+
+    static sf::Color modulate(sf::Color a, sf::Color b) {
+        return sf::Color(static_cast<uint8_t>(div255(a.r * b.r)), static_cast<uint8_t>(div255(a.g * b.g)),
+                         static_cast<uint8_t>(div255(a.b * b.b)), static_cast<uint8_t>(div255(a.a * b.a)));
+    }
+
+    uint8_t* row(int y) { return &pixels[static_cast<size_t>(y) * w * 4]; }
+    const uint8_t* row(int y) const { return &pixels[static_cast<size_t>(y) * w * 4]; }
+
+    static void fillSpan(uint8_t* out, int count, sf::Color color) {
+        const uint8_t rgba[4] = {color.r, color.g, color.b, color.a};
+        for (int i = 0; i < count; i++) std::memcpy(out + i * 4, rgba, 4);
+    }
+
+    // Each pixel times `color`, per channel
+    static void modulateSpan(uint8_t* px, int count, sf::Color color) {
+#if defined(CANVAS_SSE2)
+        const __m128i tint = _mm_setr_epi16(color.r, color.g, color.b, color.a, color.r, color.g, color.b, color.a);
+        forEachQuad(px, px, count, [&](__m128i in, __m128i) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i lo = div255(_mm_mullo_epi16(_mm_unpacklo_epi8(in, zero), tint));
+            __m128i hi = div255(_mm_mullo_epi16(_mm_unpackhi_epi8(in, zero), tint));
+            return _mm_packus_epi16(lo, hi);
+        });
+#else
+        const uint8_t rgba[4] = {color.r, color.g, color.b, color.a};
+        for (int i = 0; i < count; i++) {
+            for (int c = 0; c < 4; c++) px[i * 4 + c] = static_cast<uint8_t>(div255(px[i * 4 + c] * rgba[c]));
+        }
+#endif
+    }
+
+    // Blends `count` source pixels over `dst`:
+    //   None:  dst = src
+    //   Alpha: rgb = src * a + dst * (1 - a), alpha = src.a + dst.a * (1 - a)
+    //   Add:   rgb = dst + src * a,           alpha = dst.a + src.a   (clamped)
+    static void blendSpan(uint8_t* dst, const uint8_t* src, int count, Blend blend) {
+        if (blend == Blend::None) {
+            std::memcpy(dst, src, static_cast<size_t>(count) * 4);
+            return;
+        }
+#if defined(CANVAS_SSE2)
+        const __m128i full = _mm_set1_epi16(255);
+        const __m128i alphaLanes = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+        forEachQuad(dst, src, count, [&](__m128i d, __m128i s) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i halves[2];
+            for (int half = 0; half < 2; half++) {
+                __m128i sw = half ? _mm_unpackhi_epi8(s, zero) : _mm_unpacklo_epi8(s, zero);
+                __m128i dw = half ? _mm_unpackhi_epi8(d, zero) : _mm_unpacklo_epi8(d, zero);
+                // Each pixel's alpha in all four lanes; the source's own alpha lane scales by 1
+                __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sw, 0xFF), 0xFF);
+                __m128i srcFactor = _mm_or_si128(_mm_andnot_si128(alphaLanes, alpha), _mm_and_si128(alphaLanes, full));
+                __m128i scaled = _mm_mullo_epi16(sw, srcFactor);
+                if (blend == Blend::Alpha) {
+                    halves[half] = div255(_mm_add_epi16(scaled, _mm_mullo_epi16(dw, _mm_sub_epi16(full, alpha))));
+                } else {
+                    halves[half] = _mm_add_epi16(dw, div255(scaled));
+                }
+            }
+            return _mm_packus_epi16(halves[0], halves[1]);
+        });
+#else
+        for (int i = 0; i < count; i++) {
+            const uint8_t* s = src + i * 4;
+            uint8_t* d = dst + i * 4;
+            uint32_t a = s[3];
+            for (int c = 0; c < 4; c++) {
+                uint32_t factor = c == 3 ? 255 : a;
+                uint32_t value = blend == Blend::Alpha ? div255(s[c] * factor + d[c] * (255 - a))
+                                                       : std::min<uint32_t>(d[c] + div255(s[c] * factor), 255);
+                d[c] = static_cast<uint8_t>(value);
+            }
+        }
+#endif
+    }
+
+#if defined(CANVAS_SSE2)
+    // div255 on eight 16-bit lanes (inputs up to 255 * 255)
+    static __m128i div255(__m128i x) {
+        x = _mm_add_epi16(x, _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    }
+
+    // dst = kernel(dst, src) 4 pixels at a time. The last 1-3 pixels go
+    // through a padded copy, so short spans (most sprites are a few pixels
+    // wide) don't fall back to a scalar loop.
+    template <typename Kernel>
+    static void forEachQuad(uint8_t* dst, const uint8_t* src, int count, Kernel kernel) {
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), kernel(d, s));
+        }
+        if (i == count) return;
+        alignas(16) uint8_t d[16] = {};
+        alignas(16) uint8_t s[16] = {};
+        size_t tail = static_cast<size_t>(count - i) * 4;
+        std::memcpy(d, dst + i * 4, tail);
+        std::memcpy(s, src + i * 4, tail);
+        _mm_store_si128(reinterpret_cast<__m128i*>(d),
+                        kernel(_mm_load_si128(reinterpret_cast<const __m128i*>(d)), _mm_load_si128(reinterpret_cast<const __m128i*>(s))));
+        std::memcpy(dst + i * 4, d, tail);
+    }
+#endif
+
+    int w = 0;
+    int h = 0;
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> span;   // one row of source pixels on their way in
+    std::vector<int> columns;    // texel offsets for a quad's row
+};
@@ -0,0 +1,178 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include "SoftwareCanvas.hpp"
+
+// Where one baked primitive lives in the atlas
+struct AtlasRegion {
+    sf::FloatRect texRect;   // atlas pixels, outline included
+    sf::Vector2f origin;     // position of the shape's local (0, 0) inside texRect
+};
+
+// Texture atlas of pre-rendered shapes.
+//
+// Every neon primitive is tessellated and rasterised once at startup, with
+// its outline, into one image. After that a shape costs one textured quad.
+// Baking is done on the CPU, so the software renderer samples the very same
+// pixels; upload() copies them to a texture for the window.
+class SpriteAtlas {
+public:
+    void create(sf::Vector2u size) {
+        image.create(size.x, size.y);
+        cursor = sf::Vector2f(PADDING, PADDING);
+        rowHeight = 0;
+    }
+
+    // Rasterises `shape` at its local coordinates (its own position, origin
+    // and scale are ignored) into the next free spot
+    template <typename ShapeT>
+    AtlasRegion bake(ShapeT shape) {
+        shape.setPosition(sf::Vector2f(0, 0));
+        shape.setOrigin(sf::Vector2f(0, 0));
+        shape.setScale(sf::Vector2f(1, 1));
+
+        sf::FloatRect local = shape.getLocalBounds();
+        sf::Vector2f size(std::ceil(local.size.x), std::ceil(local.size.y));
+        sf::Vector2f spot = allocate(size);
+
+        // Overwrite instead of blending so translucent fills keep their
+        // colour and alpha and aren't darkened against the empty atlas
+        image.drawShape(shape, spot - local.position, SoftwareCanvas::Blend::None);
+
+        return AtlasRegion{sf::FloatRect(spot, size), -local.position};
+    }
+
+    // Concentric circles fading out towards the edge, tinted per sprite
+    AtlasRegion bakeGlowDot(float radius) {
+        sf::Vector2f size(radius * 2, radius * 2);
+        sf::Vector2f spot = allocate(size);
+        const float rings[3][2] = {{1.0f, 60}, {0.7f, 140}, {0.4f, 255}};
+        for (const auto& ring : rings) {
+            sf::CircleShape circle(radius * ring[0]);
+            circle.setFillColor(sf::Color(255, 255, 255, static_cast<uint8_t>(ring[1])));
+            image.drawShape(circle, spot + sf::Vector2f(radius, radius) * (1.0f - ring[0]), SoftwareCanvas::Blend::None);
+        }
+        return AtlasRegion{sf::FloatRect(spot, size), sf::Vector2f(0, 0)};
+    }
+
+    // A white block; only its centre is sampled, so stretching never bleeds
+    AtlasRegion bakeSolid() {
+        sf::Vector2f spot = allocate(sf::Vector2f(4, 4));
+        sf::RectangleShape block(sf::Vector2f(4, 4));
+        image.drawShape(block, spot, SoftwareCanvas::Blend::None);
+        return AtlasRegion{sf::FloatRect(spot + sf::Vector2f(1, 1), sf::Vector2f(2, 2)), sf::Vector2f(0, 0)};
+    }
+
+    // Needs a GL context, so only with a window
+    bool upload() {
+        if (!gpuTexture.resize(image.size())) return false;
+        gpuTexture.update(image.data());
+        return true;
+    }
+
+    const sf::Texture& texture() const { return gpuTexture; }
+    const SoftwareCanvas& pixels() const { return image; }
+
+private:
+    static constexpr float PADDING = 2.0f;
+
+    // Shelf packing: fill a row left to right, then start a new one
+    sf::Vector2f allocate(sf::Vector2f size) {
+        if (cursor.x + size.x + PADDING > image.width()) {
+            cursor = sf::Vector2f(PADDING, cursor.y + rowHeight + PADDING);
+            rowHeight = 0;
+        }
+        sf::Vector2f spot = cursor;
+        cursor.x += size.x + PADDING;
+        rowHeight = std::max(rowHeight, size.y);
+        return spot;
+    }
+
+    SoftwareCanvas image;
+    sf::Texture gpuTexture;
+    sf::Vector2f cursor;
+    float rowHeight = 0;
+};
+
+// Collects textured quads from one atlas and submits them in a single draw call
+class SpriteBatch {
+public:
+    void clear() { vertices.clear(); }
+
+    // Places a baked shape the way sf::Transformable would (position, origin, scale)
+    void add(const AtlasRegion& region, sf::Vector2f position, sf::Color color = sf::Color::White,
+             sf::Vector2f origin = sf::Vector2f(0, 0), sf::Vector2f scale = sf::Vector2f(1, 1)) {
+        sf::Vector2f offset = origin + region.origin;
+        sf::Vector2f topLeft(position.x - offset.x * scale.x, position.y - offset.y * scale.y);
+        sf::Vector2f size(region.texRect.size.x * scale.x, region.texRect.size.y * scale.y);
+        addQuad(sf::FloatRect(topLeft, size), region.texRect, color);
+    }
+
+    // Stretches a region over `rect` (dots, bars, overlays)
+    void addStretched(const AtlasRegion& region, sf::FloatRect rect, sf::Color color) {
+        addQuad(rect, region.texRect, color);
+    }
+
+    // A ribbon `width` wide through `points` (tail first), fading from clear
+    // at the tail to `color` at the head. Stored as plain triangles so any
+    // number of ribbons still go out in the batch's one draw call.
+    void addRibbon(const AtlasRegion& region, const sf::Vector2f* points, size_t count, float width, sf::Color color) {
+        if (count < 2) return;
+        sf::Vector2f tex = region.texRect.position + region.texRect.size * 0.5f;
+
+        sf::Vector2f prevLeft, prevRight;
+        sf::Color prevColor;
+        for (size_t i = 0; i < count; i++) {
+            // Offset sideways along the normal of the local direction
+            sf::Vector2f along = points[std::min(i + 1, count - 1)] - points[i > 0 ? i - 1 : 0];
+            float length = std::sqrt(along.x * along.x + along.y * along.y);
+            sf::Vector2f side = length > 0 ? sf::Vector2f(-along.y, along.x) * (width * 0.5f / length)
+                                           : sf::Vector2f(width * 0.5f, 0);
+            sf::Vector2f left = points[i] + side;
+            sf::Vector2f right = points[i] - side;
+            sf::Color shade(color.r, color.g, color.b, static_cast<uint8_t>(color.a * i / (count - 1)));
+
+            if (i > 0) {
+                vertices.append(sf::Vertex{prevLeft, prevColor, tex});
+                vertices.append(sf::Vertex{prevRight, prevColor, tex});
+                vertices.append(sf::Vertex{left, shade, tex});
+                vertices.append(sf::Vertex{left, shade, tex});
+                vertices.append(sf::Vertex{prevRight, prevColor, tex});
+                vertices.append(sf::Vertex{right, shade, tex});
+            }
+            prevLeft = left;
+            prevRight = right;
+            prevColor = shade;
+        }
+    }
+
+    void draw(sf::RenderTarget& target, const sf::Texture& atlas) const {
+        if (vertices.getVertexCount() == 0) return;
+        target.draw(vertices, sf::RenderStates(&atlas));
+    }
+
+    // The same quads rasterised on the CPU, moved by `offset`
+    void draw(SoftwareCanvas& target, const SoftwareCanvas& atlas, sf::Vector2f offset) const {
+        target.drawTriangles(vertices, &atlas, offset);
+    }
+
+    size_t spriteCount() const { return vertices.getVertexCount() / 6; }
+
+private:
+    void addQuad(sf::FloatRect rect, sf::FloatRect tex, sf::Color color) {
+        sf::Vector2f p0 = rect.position;
+        sf::Vector2f p1 = rect.position + rect.size;
+        sf::Vector2f t0 = tex.position;
+        sf::Vector2f t1 = tex.position + tex.size;
+
+        vertices.append(sf::Vertex{p0, color, t0});
+        vertices.append(sf::Vertex{sf::Vector2f(p1.x, p0.y), color, sf::Vector2f(t1.x, t0.y)});
+        vertices.append(sf::Vertex{sf::Vector2f(p0.x, p1.y), color, sf::Vector2f(t0.x, t1.y)});
+        vertices.append(sf::Vertex{sf::Vector2f(p0.x, p1.y), color, sf::Vector2f(t0.x, t1.y)});
+        vertices.append(sf::Vertex{sf::Vector2f(p1.x, p0.y), color, sf::Vector2f(t1.x, t0.y)});
+        vertices.append(sf::Vertex{p1, color, t1});
+    }
+
+    sf::VertexArray vertices{sf::PrimitiveType::Triangles};
+};
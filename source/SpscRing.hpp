@@ -0,0 +1,47 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Each side owns one index and only reads the other's, so a push
+// is a slot copy and a release store: no locks, no CAS, no allocation.
+// The producer also caches the last read index it saw and only reloads it
+// when the ring looks full, so pushes don't pull the consumer's cache line
+// over every time.
+//
+// `Capacity` must be a power of two. push() fails rather than waits when
+// the ring is full; what to do then is up to the caller.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer only
+    bool push(const T& item) {
+        size_t head = writeIndex.load(std::memory_order_relaxed);
+        if (head - cachedReadIndex == Capacity) {
+            cachedReadIndex = readIndex.load(std::memory_order_acquire);
+            if (head - cachedReadIndex == Capacity) return false;
+        }
+        slots[head & (Capacity - 1)] = item;
+        writeIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only: moves up to `max` items into `out`, oldest first
+    size_t pop(T* out, size_t max) {
+        size_t tail = readIndex.load(std::memory_order_relaxed);
+        size_t count = std::min(writeIndex.load(std::memory_order_acquire) - tail, max);
+        for (size_t i = 0; i < count; i++) out[i] = slots[(tail + i) & (Capacity - 1)];
+        readIndex.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    // Producer and consumer data on separate cache lines
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    size_t cachedReadIndex = 0;   // producer's copy of readIndex
+    alignas(64) std::atomic<size_t> readIndex{0};
+    alignas(64) T slots[Capacity];
+};
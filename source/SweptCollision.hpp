@@ -0,0 +1,198 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include "FrameArena.hpp"
+
+// Vector width for the narrow phase: AVX2 when the build enables it
+// (-mavx2 or -march=...), SSE2 on any x86-64 build, else plain C++.
+// -DSWEEP_SCALAR forces the plain path. All three give identical results.
+#if !defined(SWEEP_SCALAR) && defined(__AVX2__)
+#include <immintrin.h>
+#define SWEEP_AVX2
+#elif !defined(SWEEP_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SWEEP_SSE2
+#endif
+
+// Swept box-vs-box narrow phase.
+//
+// A single overlap test per step lets a small, fast box pass through a thin
+// one between two steps (a bullet moves 12 px a step and is 8 px tall).
+// Here each box is tested over the whole step instead: the mover slides
+// along its motion relative to the target (a slab test against the target
+// grown by the mover's size), so anything it touched on the way counts,
+// and a box that overlaps at the end of the step always counts.
+//
+// Targets are stored as one array per field, so candidates that can't be
+// reached this step are thrown out 8 (AVX2) or 4 (SSE2) at a time with
+// plain compares. Only the few left go through the slab test, which is the
+// same scalar code on every path: all builds pick the same target and
+// replays match across them.
+//
+// Like CollisionGrid, the columns live in `arena` until its next reset()
+// and clear() starts every step.
+class SweptTargets {
+public:
+    explicit SweptTargets(FrameArena& arena)
+        : minX(arena), minY(arena), maxX(arena), maxY(arena), moveX(arena), moveY(arena) {}
+
+    void clear(size_t expectedTargets = 0) {
+        minX.fresh(expectedTargets);
+        minY.fresh(expectedTargets);
+        maxX.fresh(expectedTargets);
+        maxY.fresh(expectedTargets);
+        moveX.fresh(expectedTargets);
+        moveY.fresh(expectedTargets);
+    }
+
+    // `box` is where the target ends the step after moving by `motion`.
+    // Returns its index, counting from 0 in the order of the add() calls.
+    int add(const sf::FloatRect& box, sf::Vector2f motion) {
+        minX.push_back(box.position.x);
+        minY.push_back(box.position.y);
+        maxX.push_back(box.position.x + box.size.x);
+        maxY.push_back(box.position.y + box.size.y);
+        moveX.push_back(motion.x);
+        moveY.push_back(motion.y);
+        return static_cast<int>(minX.size()) - 1;
+    }
+
+    // Everything the target covered during the step, for the broad phase
+    sf::FloatRect sweptBounds(int i) const {
+        float x0 = std::min(minX[i], minX[i] - moveX[i]);
+        float y0 = std::min(minY[i], minY[i] - moveY[i]);
+        float x1 = std::max(maxX[i], maxX[i] - moveX[i]);
+        float y1 = std::max(maxY[i], maxY[i] - moveY[i]);
+        return sf::FloatRect(sf::Vector2f(x0, y0), sf::Vector2f(x1 - x0, y1 - y0));
+    }
+
+    // Same for a mover that ends the step at `box` after moving by `motion`
+    static sf::FloatRect sweptBounds(const sf::FloatRect& box, sf::Vector2f motion) {
+        sf::Vector2f start = box.position - motion;
+        sf::Vector2f topLeft(std::min(box.position.x, start.x), std::min(box.position.y, start.y));
+        return sf::FloatRect(topLeft, box.size + sf::Vector2f(std::abs(motion.x), std::abs(motion.y)));
+    }
+
+    // The target among `candidates` that the mover touches first during the
+    // step, or -1. Ties (e.g. two targets already overlapped at the start)
+    // go to the lowest index.
+    int firstContact(const sf::FloatRect& mover, sf::Vector2f motion, const int* candidates, size_t count) const {
+        Mover m{mover.position.x, mover.position.y, mover.position.x + mover.size.x,
+                mover.position.y + mover.size.y, motion.x, motion.y};
+        Best best;
+        size_t k = 0;
+#if defined(SWEEP_AVX2)
+        for (; k + 8 <= count; k += 8) best = testAvx2(m, candidates + k, best);
+#elif defined(SWEEP_SSE2)
+        for (; k + 4 <= count; k += 4) best = testSse2(m, candidates + k, best);
+#endif
+        for (; k < count; k++) best.offer(contactKey(m, candidates[k]), candidates[k]);
+        return best.index;
+    }
+
+    size_t size() const { return minX.size(); }
+
+private:
+    struct Mover {
+        float minX, minY, maxX, maxY, moveX, moveY;
+    };
+
+    // Larger key = earlier contact; ties to the lower index
+    struct Best {
+        float key = -1.0f;
+        int index = -1;
+
+        void offer(float candidateKey, int candidate) {
+            if (candidateKey < 0) return;
+            if (candidateKey > key || (candidateKey == key && candidate < index)) {
+                key = candidateKey;
+                index = candidate;
+            }
+        }
+    };
+
+    // Works backwards from the end of the step: at s in [0, 1] the mover sits
+    // s * d behind its final place relative to the target (d is the relative
+    // motion), and the pair overlaps on an axis while d * s lies strictly
+    // between `hi` (< 0 if overlapping now) and `lo` (> 0 if overlapping now).
+    // Returns min(s at which contact ends, 1): the larger, the earlier the
+    // first contact. -1 when they never touch.
+    float contactKey(const Mover& m, int i) const {
+        float enterX, exitX, enterY, exitY;
+        if (!axisSpan(m.maxX - minX[i], m.minX - maxX[i], m.moveX - moveX[i], enterX, exitX)) return -1.0f;
+        if (!axisSpan(m.maxY - minY[i], m.minY - maxY[i], m.moveY - moveY[i], enterY, exitY)) return -1.0f;
+        float enter = std::max(enterX, enterY);
+        float exit = std::min(exitX, exitY);
+        if (!(enter < exit && enter < 1.0f && exit > 0.0f)) return -1.0f;
+        return std::min(exit, 1.0f);
+    }
+
+    static bool axisSpan(float lo, float hi, float d, float& enter, float& exit) {
+        if (d == 0.0f) {
+            enter = -std::numeric_limits<float>::infinity();
+            exit = std::numeric_limits<float>::infinity();
+            return hi < 0.0f && lo > 0.0f;
+        }
+        float s1 = lo / d;
+        float s2 = hi / d;
+        enter = std::min(s1, s2);
+        exit = std::max(s1, s2);
+        return true;
+    }
+
+#if defined(SWEEP_AVX2)
+    // Rejects 8 candidates at once with compares only, then works out the
+    // contact of the few left with contactKey(). The reject is conservative
+    // (on each axis the relative motion has to reach into the overlap
+    // range at all), so the outcome is exactly the scalar one.
+    Best testAvx2(const Mover& m, const int* idx, Best best) const {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx));
+        __m256 loX = _mm256_sub_ps(_mm256_set1_ps(m.maxX), _mm256_i32gather_ps(minX.data(), index, 4));
+        __m256 hiX = _mm256_sub_ps(_mm256_set1_ps(m.minX), _mm256_i32gather_ps(maxX.data(), index, 4));
+        __m256 dX = _mm256_sub_ps(_mm256_set1_ps(m.moveX), _mm256_i32gather_ps(moveX.data(), index, 4));
+        __m256 loY = _mm256_sub_ps(_mm256_set1_ps(m.maxY), _mm256_i32gather_ps(minY.data(), index, 4));
+        __m256 hiY = _mm256_sub_ps(_mm256_set1_ps(m.minY), _mm256_i32gather_ps(maxY.data(), index, 4));
+        __m256 dY = _mm256_sub_ps(_mm256_set1_ps(m.moveY), _mm256_i32gather_ps(moveY.data(), index, 4));
+
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 reachX = _mm256_and_ps(_mm256_cmp_ps(hiX, _mm256_max_ps(dX, zero), _CMP_LT_OQ),
+                                      _mm256_cmp_ps(loX, _mm256_min_ps(dX, zero), _CMP_GT_OQ));
+        __m256 reachY = _mm256_and_ps(_mm256_cmp_ps(hiY, _mm256_max_ps(dY, zero), _CMP_LT_OQ),
+                                      _mm256_cmp_ps(loY, _mm256_min_ps(dY, zero), _CMP_GT_OQ));
+        int mask = _mm256_movemask_ps(_mm256_and_ps(reachX, reachY));
+        for (int lane = 0; lane < 8; lane++) {
+            if (mask & (1 << lane)) best.offer(contactKey(m, idx[lane]), idx[lane]);
+        }
+        return best;
+    }
+#elif defined(SWEEP_SSE2)
+    static __m128 gather(const FrameVector<float>& column, const int* idx) {
+        return _mm_set_ps(column[idx[3]], column[idx[2]], column[idx[1]], column[idx[0]]);
+    }
+
+    // Same as testAvx2, 4 at a time
+    Best testSse2(const Mover& m, const int* idx, Best best) const {
+        __m128 loX = _mm_sub_ps(_mm_set1_ps(m.maxX), gather(minX, idx));
+        __m128 hiX = _mm_sub_ps(_mm_set1_ps(m.minX), gather(maxX, idx));
+        __m128 dX = _mm_sub_ps(_mm_set1_ps(m.moveX), gather(moveX, idx));
+        __m128 loY = _mm_sub_ps(_mm_set1_ps(m.maxY), gather(minY, idx));
+        __m128 hiY = _mm_sub_ps(_mm_set1_ps(m.minY), gather(maxY, idx));
+        __m128 dY = _mm_sub_ps(_mm_set1_ps(m.moveY), gather(moveY, idx));
+
+        const __m128 zero = _mm_setzero_ps();
+        __m128 reachX = _mm_and_ps(_mm_cmplt_ps(hiX, _mm_max_ps(dX, zero)), _mm_cmpgt_ps(loX, _mm_min_ps(dX, zero)));
+        __m128 reachY = _mm_and_ps(_mm_cmplt_ps(hiY, _mm_max_ps(dY, zero)), _mm_cmpgt_ps(loY, _mm_min_ps(dY, zero)));
+        int mask = _mm_movemask_ps(_mm_and_ps(reachX, reachY));
+        for (int lane = 0; lane < 4; lane++) {
+            if (mask & (1 << lane)) best.offer(contactKey(m, idx[lane]), idx[lane]);
+        }
+        return best;
+    }
+#endif
+
+    FrameVector<float> minX, minY, maxX, maxY;
+    FrameVector<float> moveX, moveY;   // distance moved this step
+};
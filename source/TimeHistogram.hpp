@@ -0,0 +1,49 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Durations counted in fixed-width buckets, so adding one is O(1) and
+// percentiles can be read at any time without keeping every sample.
+// Anything past the last bucket is counted in it (and still sets max).
+class TimeHistogram {
+public:
+    TimeHistogram(int64_t bucketUs, int bucketCount) : bucketUs(bucketUs), buckets(bucketCount, 0) {}
+
+    void add(int64_t us) {
+        us = std::max<int64_t>(us, 0);
+        buckets[static_cast<size_t>(std::min<int64_t>(us / bucketUs, static_cast<int64_t>(buckets.size()) - 1))]++;
+        samples++;
+        total += us;
+        worst = std::max(worst, us);
+    }
+
+    // Upper edge of the bucket holding the p-th percentile, in ms
+    float percentileMs(float p) const {
+        uint64_t rank = static_cast<uint64_t>(p / 100.0f * samples);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if (seen > rank) return std::min(static_cast<int64_t>(i + 1) * bucketUs, worst) / 1000.0f;
+        }
+        return maxMs();
+    }
+
+    float meanMs() const { return samples ? total / 1000.0f / samples : 0.0f; }
+    float maxMs() const { return worst / 1000.0f; }
+    uint64_t count() const { return samples; }
+
+    void clear() {
+        std::fill(buckets.begin(), buckets.end(), 0);
+        samples = 0;
+        total = 0;
+        worst = 0;
+    }
+
+private:
+    int64_t bucketUs;
+    std::vector<uint64_t> buckets;
+    uint64_t samples = 0;
+    int64_t total = 0;
+    int64_t worst = 0;
+};
@@ -0,0 +1,240 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Level and enemy definitions, compiled offline by wavec from a text file
+// (see levels/waves.txt) into a .nsaw file.
+//
+// The file is a header followed by two arrays of fixed-size little-endian
+// records, 4-byte aligned, so the game maps it and reads the records in
+// place; nothing is parsed or copied at startup. Each level carries a
+// 100-entry spawn table precomputed from its enemy mix, so picking an enemy
+// is a single lookup with a d100 roll.
+//
+// Layout (version 1):
+//   WaveFileHeader
+//   EnemyArchetype[archetypeCount]   at archetypeOffset
+//   LevelDef[levelCount]             at levelOffset
+
+const uint32_t WAVE_FILE_VERSION = 1;
+const int SPAWN_TABLE_SIZE = 100;
+
+// EnemyArchetype::flags
+const uint32_t ARCHETYPE_BOSS = 1;        // spawned alone and centred, thick health bar
+const uint32_t ARCHETYPE_ENDS_GAME = 2;   // killing it ends the run
+
+struct WaveFileHeader {
+    char magic[4];              // "NSAW"
+    uint32_t version;
+    uint32_t fileSize;
+    uint32_t archetypeCount;
+    uint32_t archetypeOffset;
+    uint32_t levelCount;
+    uint32_t levelOffset;
+    uint32_t reserved;
+};
+
+struct EnemyArchetype {
+    float width;
+    float height;
+    uint8_t color[4];           // RGBA fill
+    float outline;
+    float speedScale;           // times the level's enemy speed...
+    float fixedSpeed;           // ...unless this is > 0
+    int32_t health;
+    int32_t healthPerLevel;     // added once per level number
+    int32_t points;             // times level number and combo
+    int32_t bonus;              // flat, on top of points
+    float spawnY;
+    uint32_t flags;
+};
+
+struct LevelDef {
+    float enemySpeed;
+    float spawnInterval;
+    int32_t killsToAdvance;
+    int32_t bossArchetype;      // spawned on entering the level, -1 for none
+    uint8_t spawnTable[SPAWN_TABLE_SIZE];   // d100 roll -> archetype index
+};
+
+static_assert(sizeof(WaveFileHeader) == 32, "wave file header must stay 32 bytes");
+static_assert(sizeof(EnemyArchetype) == 48, "archetype record must stay 48 bytes");
+static_assert(sizeof(LevelDef) == 116, "level record must stay 116 bytes");
+
+// Fills a spawn table from percentages for archetypes 0, 1, 2, ...
+// (first archetype takes the lowest rolls)
+template <size_t N>
+constexpr LevelDef makeLevel(float speed, float interval, int32_t kills, int32_t boss, const int (&mix)[N]) {
+    LevelDef level{speed, interval, kills, boss, {}};
+    int roll = 0;
+    for (size_t type = 0; type < N; type++) {
+        for (int i = 0; i < mix[type] && roll < SPAWN_TABLE_SIZE; i++) {
+            level.spawnTable[roll++] = static_cast<uint8_t>(type);
+        }
+    }
+    return level;
+}
+
+// Used when no wave file is loaded; levels/waves.txt compiles to the same data
+constexpr EnemyArchetype DEFAULT_ARCHETYPES[] = {
+    // w     h     color                  outline speed fixed health +lvl points bonus spawnY  flags
+    {40.f, 30.f, {255, 50, 50, 255}, 2.f, 1.0f, 0.f, 1, 0, 10, 0, -50.f, 0},     // normal
+    {30.f, 25.f, {255, 150, 0, 255}, 2.f, 1.3f, 0.f, 1, 0, 15, 0, -50.f, 0},     // fast
+    {50.f, 40.f, {150, 0, 255, 255}, 2.f, 0.6f, 0.f, 3, 1, 30, 0, -50.f, 0},     // tank
+    {180.f, 120.f, {180, 50, 255, 255}, 4.f, 1.0f, 0.9f, 100, 0, 10, 5000, -150.f,
+     ARCHETYPE_BOSS | ARCHETYPE_ENDS_GAME},                                       // boss
+};
+
+constexpr int LEVEL1_MIX[] = {70, 20, 10};
+constexpr int LEVEL2_MIX[] = {50, 30, 20};
+constexpr int LEVEL3_MIX[] = {30, 40, 30};
+constexpr LevelDef DEFAULT_LEVELS[] = {
+    makeLevel(2.0f, 1.2f, 15, -1, LEVEL1_MIX),
+    makeLevel(3.5f, 0.9f, 25, -1, LEVEL2_MIX),
+    makeLevel(5.0f, 0.6f, 999, 3, LEVEL3_MIX),
+};
+
+// Checks that `size` bytes at `data` form a usable wave file.
+// Returns nullptr when they do, otherwise what is wrong.
+inline const char* validateWaveData(const uint8_t* data, size_t size) {
+    if (size < sizeof(WaveFileHeader)) return "file too small";
+    WaveFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, "NSAW", 4) != 0) return "not a wave file";
+    if (header.version != WAVE_FILE_VERSION) return "unsupported version";
+    if (header.fileSize != size) return "truncated file";
+    if (header.archetypeCount == 0 || header.archetypeCount > 255) return "bad archetype count";
+    if (header.levelCount == 0) return "no levels";
+    if (header.archetypeOffset % 4 != 0 || header.levelOffset % 4 != 0) return "misaligned records";
+    if (header.archetypeOffset > size || size - header.archetypeOffset < uint64_t(header.archetypeCount) * sizeof(EnemyArchetype))
+        return "archetypes out of bounds";
+    if (header.levelOffset > size || size - header.levelOffset < uint64_t(header.levelCount) * sizeof(LevelDef))
+        return "levels out of bounds";
+
+    for (uint32_t i = 0; i < header.levelCount; i++) {
+        LevelDef level;
+        std::memcpy(&level, data + header.levelOffset + i * sizeof(LevelDef), sizeof(level));
+        if (level.bossArchetype >= static_cast<int32_t>(header.archetypeCount)) return "boss archetype out of range";
+        for (uint8_t type : level.spawnTable) {
+            if (type >= header.archetypeCount) return "spawn table archetype out of range";
+        }
+    }
+    return nullptr;
+}
+
+// Read-only view of a mapped wave file, or of the built-in tables
+class WaveFile {
+public:
+    WaveFile() = default;
+    ~WaveFile() { close(); }
+
+    WaveFile(const WaveFile&) = delete;
+    WaveFile& operator=(const WaveFile&) = delete;
+
+    // Maps and validates `path`. On failure the built-in tables stay in use
+    // and `error` (if given) says why.
+    bool open(const std::string& path, std::string* error = nullptr) {
+        close();
+        const char* problem = map(path) ? validateWaveData(mapped, mappedSize) : "cannot open file";
+        if (problem) {
+            close();
+            if (error) *error = problem;
+            return false;
+        }
+
+        WaveFileHeader header;
+        std::memcpy(&header, mapped, sizeof(header));
+        archetypes = reinterpret_cast<const EnemyArchetype*>(mapped + header.archetypeOffset);
+        archetypeTotal = static_cast<int>(header.archetypeCount);
+        levels = reinterpret_cast<const LevelDef*>(mapped + header.levelOffset);
+        levelTotal = static_cast<int>(header.levelCount);
+        return true;
+    }
+
+    const EnemyArchetype& archetype(int index) const { return archetypes[index]; }
+    int archetypeCount() const { return archetypeTotal; }
+
+    // Levels are numbered from 1; past the last one the last level repeats
+    const LevelDef& level(int number) const {
+        int index = number < 1 ? 0 : (number > levelTotal ? levelTotal - 1 : number - 1);
+        return levels[index];
+    }
+    int levelCount() const { return levelTotal; }
+
+    bool isMapped() const { return mapped != nullptr; }
+
+private:
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) return false;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return false;
+        mapped = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        mappedSize = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);   // the mapping keeps the file alive
+        if (view == MAP_FAILED) return false;
+        mapped = static_cast<const uint8_t*>(view);
+        mappedSize = static_cast<size_t>(info.st_size);
+#endif
+        return mapped != nullptr;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (mapped) UnmapViewOfFile(mapped);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (mapped) munmap(const_cast<uint8_t*>(mapped), mappedSize);
+#endif
+        mapped = nullptr;
+        mappedSize = 0;
+        archetypes = DEFAULT_ARCHETYPES;
+        archetypeTotal = static_cast<int>(sizeof(DEFAULT_ARCHETYPES) / sizeof(DEFAULT_ARCHETYPES[0]));
+        levels = DEFAULT_LEVELS;
+        levelTotal = static_cast<int>(sizeof(DEFAULT_LEVELS) / sizeof(DEFAULT_LEVELS[0]));
+    }
+
+    const uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    const EnemyArchetype* archetypes = DEFAULT_ARCHETYPES;
+    int archetypeTotal = static_cast<int>(sizeof(DEFAULT_ARCHETYPES) / sizeof(DEFAULT_ARCHETYPES[0]));
+    const LevelDef* levels = DEFAULT_LEVELS;
+    int levelTotal = static_cast<int>(sizeof(DEFAULT_LEVELS) / sizeof(DEFAULT_LEVELS[0]));
+};
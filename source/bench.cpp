@@ -0,0 +1,474 @@
+// Scenario benchmarks for the simulation.
+//
+// Runs the game headlessly (no window, no GL) through scripted scenarios and
+// prints one JSON document with per-stage ns/tick, heap allocations per tick,
+// tick-time percentiles, snapshot save/load cost, the cost of a software
+// rendered frame and of logging an event, so two builds can be compared
+// run against run.
+//
+// --zero-alloc makes it fail (exit 2) if any timed tick or software frame
+// touched the heap: after warm-up the game is meant to run allocation free.
+//
+// Usage: bench [--ticks N] [--warmup N] [--seed N] [--threads N] [--scenario NAME] [--out FILE] [--zero-alloc]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+#include "Game.hpp"
+
+// =======================
+// ALLOCATION COUNTING
+// =======================
+// Every heap allocation in this executable goes through here (the array and
+// sized forms forward to these), including the ones made by worker threads.
+// A profiler build also charges them to zones, as the game does.
+static std::atomic<uint64_t> allocCount{0};
+static std::atomic<uint64_t> allocBytes{0};
+
+void* operator new(size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+#ifdef PROFILER_ENABLED
+    Profiler::countAllocation(size);
+#endif
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// GCC flags free() on memory from `new`, not seeing that this is that `new`
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// =======================
+// BENCH DRIVER
+// =======================
+#ifdef __VERSION__
+const char* const COMPILER = __VERSION__;
+#else
+const char* const COMPILER = "unknown";
+#endif
+
+#if defined(SWEEP_AVX2)
+const char* const NARROW_PHASE = "avx2";
+#elif defined(SWEEP_SSE2)
+const char* const NARROW_PHASE = "sse2";
+#else
+const char* const NARROW_PHASE = "scalar";
+#endif
+
+#if defined(CANVAS_SSE2)
+const char* const CANVAS_SPANS = "sse2";
+#else
+const char* const CANVAS_SPANS = "scalar";
+#endif
+
+enum Stage { STAGE_INPUT, STAGE_GAMEPLAY, STAGE_PARTICLES, STAGE_TRAILS, STAGE_STARS, STAGE_COUNT };
+const char* const STAGE_NAMES[STAGE_COUNT] = {"input", "gameplay", "particles", "trails", "stars"};
+
+struct TickSample {
+    uint64_t stageNs[STAGE_COUNT] = {};
+    uint64_t totalNs = 0;
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+};
+
+// Owns one headless Game and steps it stage by stage. The stages are the
+// ones Game::update puts in its task graph, run here one after another so
+// each can be timed on its own; loops inside a stage still use the workers.
+class GameBench {
+public:
+    GameBench(uint32_t seed, unsigned workerThreads, size_t enemyCapacity)
+        : game(true, seed, workerThreads, enemyCapacity) {
+        rng.seed(seed, 100);
+    }
+
+    TickSample tick(long long tickIndex) {
+        // Fire constantly and sweep left/right across the screen
+        PlayerInput& input = game.players[0].input;
+        input = PlayerInput();
+        input.fire = true;
+        bool goingLeft = (tickIndex / 90) % 2 == 0;
+        input.left = goingLeft;
+        input.right = !goingLeft;
+
+        TickSample sample;
+        uint64_t allocsBefore = allocCount.load(std::memory_order_relaxed);
+        uint64_t bytesBefore = allocBytes.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        auto last = start;
+        auto lap = [&](Stage stage) {
+            auto now = Clock::now();
+            sample.stageNs[stage] = nanoseconds(now - last);
+            last = now;
+        };
+
+        game.players[0].prevPosition = game.players[0].position;
+        game.applyInput();
+        lap(STAGE_INPUT);
+        game.updateGameplay(SIM_DT);
+        lap(STAGE_GAMEPLAY);
+        game.updateParticles(SIM_DT);
+        lap(STAGE_PARTICLES);
+        game.updateTrails();
+        lap(STAGE_TRAILS);
+        game.updateStars();
+        lap(STAGE_STARS);
+
+        sample.totalNs = nanoseconds(last - start);
+        sample.allocs = allocCount.load(std::memory_order_relaxed) - allocsBefore;
+        sample.bytes = allocBytes.load(std::memory_order_relaxed) - bytesBefore;
+        return sample;
+    }
+
+    // Scenarios run until told to stop, so the player never dies and the
+    // level never advances (update() would skip every stage during either)
+    void keepAlive() {
+        game.lives = 1000000;
+        game.gameOver = false;
+        game.levelTransition = false;
+        game.enemiesNeededForNextLevel = INT_MAX;
+    }
+
+    // Tops the enemy table up to `target`, spread over the whole screen
+    void fillEnemies(size_t target) {
+        while (game.enemies.size() < target && game.enemies.size() < game.enemies.capacity()) {
+            game.spawnEnemy();
+        }
+        Position* position = game.enemies.column<Position>();
+        for (uint32_t row = 0; row < game.enemies.size(); row++) {
+            if (position[row].value.y < 0) {
+                float x = static_cast<float>(rng.nextInt(game.width - 50));
+                float y = static_cast<float>(rng.nextInt(game.height - 100));
+                position[row].value = sf::Vector2f(x, y);
+            }
+        }
+    }
+
+    // Tops the particle system up to `target` with explosions all over the screen
+    void fillParticles(size_t target) {
+        while (game.particles.size() < target && game.particles.size() < game.particles.maxSize()) {
+            sf::Vector2f position(static_cast<float>(rng.nextInt(game.width)), static_cast<float>(rng.nextInt(game.height)));
+            game.createExplosion(position, game.neonOrange);
+        }
+    }
+
+    // Tops enemy projectiles up to `target` with rings fired from all over
+    // the top half of the screen. The player holds a shield, so the ones that
+    // reach it are absorbed instead of clearing the screen.
+    void fillProjectiles(size_t target) {
+        BossPattern ring{PatternKind::RING, 1, 1, 32, 0.0f, 0.1f, 0};
+        while (game.projectiles.size() + ring.count <= target) {
+            sf::Vector2f origin(static_cast<float>(rng.nextInt(game.width)), static_cast<float>(rng.nextInt(game.height / 2)));
+            ring.speed = 1.0f + rng.nextInt(3);
+            ring.style = rng.nextInt(PROJECTILE_STYLES);
+            game.firePattern(ring, rng.nextInt(64), origin);
+        }
+        game.hasShield = true;
+        game.shieldTimer = 10.0f;
+    }
+
+    void holdTripleShotRapidFire() {
+        game.hasTripleShot = true;
+        game.tripleShotTimer = 12.0f;
+        game.rapidFire = true;
+        game.rapidFireTimer = 8.0f;
+    }
+
+    void enterBossLevel() {
+        game.currentLevel = 2;
+        game.startLevelTransition();
+    }
+
+    void keepBoss() {
+        int boss = game.waves.level(game.currentLevel).bossArchetype;
+        if (boss >= 0 && !game.enemies.isAlive(game.bossEntity)) game.spawnBoss(boss);
+    }
+
+    struct SnapshotTiming {
+        size_t bytes = 0;
+        double saveNs = 0;
+        double loadNs = 0;
+    };
+
+    // Average cost of saving the current state and loading it back. Loading
+    // the state just saved leaves the run unchanged.
+    SnapshotTiming timeSnapshots(int rounds) {
+        Snapshot snapshot;
+        game.saveSnapshot(snapshot);   // grows the buffer outside the timing
+        SnapshotTiming timing;
+        timing.bytes = snapshot.bytes.size();
+        auto start = Clock::now();
+        for (int i = 0; i < rounds; i++) game.saveSnapshot(snapshot);
+        auto saved = Clock::now();
+        for (int i = 0; i < rounds; i++) game.loadSnapshot(snapshot);
+        timing.saveNs = static_cast<double>(nanoseconds(saved - start)) / rounds;
+        timing.loadNs = static_cast<double>(nanoseconds(Clock::now() - saved)) / rounds;
+        return timing;
+    }
+
+    struct RenderTiming {
+        double ns = 0;
+        uint64_t allocs = 0;
+    };
+
+    // Average cost of drawing the current state with the software renderer
+    RenderTiming timeSoftwareRender(int frames) {
+        game.enableSoftwareRender();
+        game.lives = 3;     // keepAlive()'s lives would be a million hearts of HUD text
+        game.drawFrame();   // lays the HUD text out and grows the batches outside the timing
+        RenderTiming timing;
+        uint64_t allocsBefore = allocCount.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        for (int i = 0; i < frames; i++) game.drawFrame();
+        timing.ns = static_cast<double>(nanoseconds(Clock::now() - start)) / frames;
+        timing.allocs = allocCount.load(std::memory_order_relaxed) - allocsBefore;
+        return timing;
+    }
+
+    size_t enemyCount() const { return game.enemies.size(); }
+    size_t bulletCount() const { return game.bullets.size(); }
+    size_t particleCount() const { return game.particles.size(); }
+    size_t projectileCount() const { return game.projectiles.size(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static uint64_t nanoseconds(Clock::duration d) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    }
+
+    Game game;
+    Rng rng;   // scenario placement, separate from the game's own streams
+};
+
+struct Scenario {
+    const char* name;
+    const char* description;
+    size_t enemyCapacity;
+    std::function<void(GameBench&)> setup;     // once, before warm-up
+    std::function<void(GameBench&)> sustain;   // before every tick, not timed
+};
+
+const std::vector<Scenario>& scenarios() {
+    static const std::vector<Scenario> list = {
+        {"enemies_10k", "10000 enemies on screen, player firing", 10240,
+         [](GameBench&) {},
+         [](GameBench& b) { b.fillEnemies(10000); }},
+        {"particles_100k", "100000 live explosion particles", MAX_ENEMIES,
+         [](GameBench&) {},
+         [](GameBench& b) { b.fillParticles(100000); }},
+        {"triple_shot_rapid_fire", "triple shot and rapid fire held, level 1 spawns", MAX_ENEMIES,
+         [](GameBench&) {},
+         [](GameBench& b) { b.holdTripleShotRapidFire(); }},
+        {"boss", "level 3 boss fight, boss respawned when killed", MAX_ENEMIES,
+         [](GameBench& b) { b.enterBossLevel(); },
+         [](GameBench& b) { b.keepBoss(); }},
+        {"bullet_hell_10k", "boss fight with 10000 enemy projectiles in flight, player shielded", MAX_ENEMIES,
+         [](GameBench& b) { b.enterBossLevel(); },
+         [](GameBench& b) {
+             b.keepBoss();
+             b.fillProjectiles(10000);
+         }},
+    };
+    return list;
+}
+
+// Game-thread cost of EventLog::push() with the writer running. Each round
+// gets a fresh log and fills its ring exactly, so nothing is dropped.
+double timeEventPush() {
+    using Clock = std::chrono::steady_clock;
+    const int rounds = 20;
+    const char* path = "bench_events.nsel";
+    uint64_t totalNs = 0;
+    for (int round = 0; round < rounds; round++) {
+        EventLog log(path, 1);
+        if (!log.ok()) return -1;
+        auto start = Clock::now();
+        for (size_t i = 0; i < EventLog::RING_EVENTS; i++) {
+            log.push(GameEvent{static_cast<uint32_t>(i), GameEventType::KILL, 1, 2, 30, 100, static_cast<int16_t>(i & 511)});
+        }
+        totalNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+    std::remove(path);
+    return static_cast<double>(totalNs) / (rounds * EventLog::RING_EVENTS);
+}
+
+// Nearest-rank percentile of an ascending list
+uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.5);
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+struct BenchOptions {
+    long long ticks = 3000;
+    long long warmup = 300;
+    uint32_t seed = 1;
+    unsigned workerThreads = 0;
+    std::string only;
+    bool zeroAlloc = false;
+};
+
+// Runs one scenario and appends its JSON object to `json`. Returns the
+// heap allocations made in the timed ticks and software frames.
+uint64_t runScenario(const Scenario& scenario, const BenchOptions& options, std::string& json) {
+    GameBench bench(options.seed, options.workerThreads, scenario.enemyCapacity);
+    scenario.setup(bench);
+
+    for (long long i = 0; i < options.warmup; i++) {
+        bench.keepAlive();
+        scenario.sustain(bench);
+        bench.tick(i);
+    }
+
+    std::vector<TickSample> samples;
+    samples.reserve(static_cast<size_t>(options.ticks));
+    size_t peakEnemies = 0, peakBullets = 0, peakParticles = 0, peakProjectiles = 0;
+    for (long long i = 0; i < options.ticks; i++) {
+        bench.keepAlive();
+        scenario.sustain(bench);
+        samples.push_back(bench.tick(options.warmup + i));
+        peakEnemies = std::max(peakEnemies, bench.enemyCount());
+        peakBullets = std::max(peakBullets, bench.bulletCount());
+        peakParticles = std::max(peakParticles, bench.particleCount());
+        peakProjectiles = std::max(peakProjectiles, bench.projectileCount());
+    }
+    GameBench::SnapshotTiming snapshot = bench.timeSnapshots(100);
+    GameBench::RenderTiming render = bench.timeSoftwareRender(50);
+
+    uint64_t stageTotals[STAGE_COUNT] = {};
+    uint64_t allocTotal = 0, byteTotal = 0, maxAllocs = 0, ticksWithAllocs = 0;
+    std::vector<uint64_t> tickNs;
+    tickNs.reserve(samples.size());
+    for (const auto& s : samples) {
+        for (int st = 0; st < STAGE_COUNT; st++) stageTotals[st] += s.stageNs[st];
+        allocTotal += s.allocs;
+        byteTotal += s.bytes;
+        maxAllocs = std::max(maxAllocs, s.allocs);
+        if (s.allocs > 0) ticksWithAllocs++;
+        tickNs.push_back(s.totalNs);
+    }
+    std::sort(tickNs.begin(), tickNs.end());
+
+    double n = static_cast<double>(samples.size());
+    uint64_t total = 0;
+    for (uint64_t ns : tickNs) total += ns;
+
+    char buf[512];
+    json += "    {\n";
+    snprintf(buf, sizeof(buf), "      \"name\": \"%s\",\n      \"description\": \"%s\",\n      \"ticks\": %lld,\n",
+             scenario.name, scenario.description, options.ticks);
+    json += buf;
+    json += "      \"ns_per_tick\": {";
+    for (int st = 0; st < STAGE_COUNT; st++) {
+        snprintf(buf, sizeof(buf), "\"%s\": %.0f, ", STAGE_NAMES[st], stageTotals[st] / n);
+        json += buf;
+    }
+    snprintf(buf, sizeof(buf), "\"total\": %.0f},\n", total / n);
+    json += buf;
+    snprintf(buf, sizeof(buf),
+             "      \"tick_ns\": {\"p50\": %llu, \"p90\": %llu, \"p95\": %llu, \"p99\": %llu, \"max\": %llu},\n",
+             (unsigned long long)percentile(tickNs, 50), (unsigned long long)percentile(tickNs, 90),
+             (unsigned long long)percentile(tickNs, 95), (unsigned long long)percentile(tickNs, 99),
+             (unsigned long long)tickNs.back());
+    json += buf;
+    snprintf(buf, sizeof(buf),
+             "      \"allocs_per_tick\": %.2f,\n      \"bytes_per_tick\": %.0f,\n"
+             "      \"max_allocs_in_tick\": %llu,\n      \"ticks_with_allocs\": %llu,\n",
+             allocTotal / n, byteTotal / n, (unsigned long long)maxAllocs, (unsigned long long)ticksWithAllocs);
+    json += buf;
+    snprintf(buf, sizeof(buf), "      \"snapshot\": {\"bytes\": %zu, \"save_ns\": %.0f, \"load_ns\": %.0f},\n",
+             snapshot.bytes, snapshot.saveNs, snapshot.loadNs);
+    json += buf;
+    snprintf(buf, sizeof(buf), "      \"software_render_ns\": %.0f,\n      \"software_render_allocs\": %llu,\n", render.ns,
+             (unsigned long long)render.allocs);
+    json += buf;
+    snprintf(buf, sizeof(buf),
+             "      \"peak\": {\"enemies\": %zu, \"bullets\": %zu, \"particles\": %zu, \"projectiles\": %zu}\n",
+             peakEnemies, peakBullets, peakParticles, peakProjectiles);
+    json += buf;
+    json += "    }";
+    return allocTotal + render.allocs;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    std::string outPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--ticks" && i + 1 < argc) {
+            options.ticks = std::max(1LL, std::stoll(argv[++i]));
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            options.warmup = std::max(0LL, std::stoll(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.workerThreads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--scenario" && i + 1 < argc) {
+            options.only = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "--zero-alloc") {
+            options.zeroAlloc = true;
+        } else {
+            fprintf(stderr, "usage: bench [--ticks N] [--warmup N] [--seed N] [--threads N] [--scenario NAME] [--out FILE] "
+                            "[--zero-alloc]\n");
+            return 1;
+        }
+    }
+
+    char buf[256];
+    std::string json = "{\n";
+    snprintf(buf, sizeof(buf),
+             "  \"compiler\": \"%s\",\n  \"narrow_phase\": \"%s\",\n  \"canvas_spans\": \"%s\",\n  \"seed\": %u,\n"
+             "  \"threads\": %u,\n  \"warmup_ticks\": %lld,\n  \"event_push_ns\": %.1f,\n",
+             COMPILER, NARROW_PHASE, CANVAS_SPANS, options.seed, options.workerThreads + 1, options.warmup, timeEventPush());
+    json += buf;
+    json += "  \"scenarios\": [\n";
+
+    bool first = true;
+    std::string allocating;   // scenarios that failed --zero-alloc
+    for (const auto& scenario : scenarios()) {
+        if (!options.only.empty() && options.only != scenario.name) continue;
+        if (!first) json += ",\n";
+        first = false;
+        fprintf(stderr, "running %s...\n", scenario.name);
+        uint64_t allocs = runScenario(scenario, options, json);
+        if (allocs > 0) {
+            snprintf(buf, sizeof(buf), " %s (%llu)", scenario.name, (unsigned long long)allocs);
+            allocating += buf;
+        }
+    }
+    json += "\n  ]\n}\n";
+
+    if (first) {
+        fprintf(stderr, "unknown scenario %s\n", options.only.c_str());
+        return 1;
+    }
+
+    fputs(json.c_str(), stdout);
+    if (!outPath.empty()) {
+        FILE* file = fopen(outPath.c_str(), "w");
+        if (!file || fputs(json.c_str(), file) < 0) {
+            fprintf(stderr, "could not write %s\n", outPath.c_str());
+            if (file) fclose(file);
+            return 1;
+        }
+        fclose(file);
+    }
+    if (options.zeroAlloc && !allocating.empty()) {
+        fprintf(stderr, "heap allocations after warm-up:%s\n", allocating.c_str());
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+// Event log reader: summarises a session log written with --event-log, for
+// balancing levels, or dumps every event as CSV for other tools.
+//
+// Usage: eventlog FILE.nsel
+//        eventlog --csv FILE.nsel
+//
+// The summary has one line per run (score, level reached, length) and a
+// table per level over all runs: time spent, kills, points, lives lost,
+// power-ups and combo lengths. Steps undone by a rewind or a quick load
+// (a state_loaded event) are dropped first, so they count once.
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+#include "EventLog.hpp"
+
+const double STEPS_PER_SECOND = 60.0;   // Game.hpp's SIM_DT
+const char* const POWER_UP_NAMES[] = {"rapid_fire", "shield", "triple_shot"};   // PowerUpType order
+const int POWER_UP_TYPES = 3;
+
+struct LevelStats {
+    uint64_t steps = 0;
+    int kills = 0;
+    int64_t points = 0;
+    int livesLost = 0;
+    int pickups[POWER_UP_TYPES] = {};
+    int combos = 0;
+    int64_t comboKills = 0;
+    int longestCombo = 0;
+    int bossesDefeated = 0;
+};
+
+struct RunStats {
+    uint32_t startStep = 0;
+    uint32_t endStep = 0;
+    int level = 1;
+    int score = 0;
+    bool over = false;
+    bool won = false;
+};
+
+// The events that still count after rewinds and quick loads: a load back to
+// step S undoes everything logged from step S on
+static std::vector<GameEvent> effectiveEvents(const std::vector<GameEvent>& events) {
+    std::vector<GameEvent> kept;
+    for (const GameEvent& event : events) {
+        if (event.type == GameEventType::STATE_LOADED) {
+            while (!kept.empty() && kept.back().step >= event.step) kept.pop_back();
+            continue;
+        }
+        kept.push_back(event);
+    }
+    return kept;
+}
+
+static void printCsv(const EventLogFile& log) {
+    std::printf("step,type,level,detail,value,x,y\n");
+    for (const GameEvent& event : log.events) {
+        std::printf("%u,%s,%d,%d,%d,%d,%d\n", event.step, GAME_EVENT_NAMES[static_cast<int>(event.type)], event.level,
+                    event.detail, event.value, event.x, event.y);
+    }
+}
+
+static void printSummary(const EventLogFile& log) {
+    std::vector<GameEvent> events = effectiveEvents(log.events);
+
+    std::vector<RunStats> runs;
+    std::map<int, LevelStats> levels;
+    std::map<int, int> killsByArchetype;
+    int currentLevel = 1;
+    uint32_t levelStart = 0;
+    auto closeLevel = [&](uint32_t step) {
+        if (!runs.empty() && !runs.back().over) levels[currentLevel].steps += step - levelStart;
+        levelStart = step;
+    };
+
+    for (const GameEvent& event : events) {
+        if (event.type != GameEventType::RUN_START && runs.empty()) runs.push_back(RunStats());   // log started mid-run
+        RunStats* run = runs.empty() ? nullptr : &runs.back();
+        LevelStats& level = levels[event.level];
+        switch (event.type) {
+            case GameEventType::RUN_START:
+                if (run && !run->over) {
+                    closeLevel(event.step);
+                    run->endStep = event.step;
+                }
+                runs.push_back(RunStats());
+                runs.back().startStep = event.step;
+                runs.back().level = event.level;
+                currentLevel = event.level;
+                levelStart = event.step;
+                break;
+            case GameEventType::KILL:
+                level.kills++;
+                level.points += event.value;
+                run->score += event.value;
+                killsByArchetype[event.detail]++;
+                break;
+            case GameEventType::BOSS_DEFEATED:
+                level.bossesDefeated++;
+                break;
+            case GameEventType::COMBO_END:
+                level.combos++;
+                level.comboKills += event.value;
+                level.longestCombo = std::max(level.longestCombo, event.value);
+                break;
+            case GameEventType::PICKUP:
+                if (event.detail < POWER_UP_TYPES) level.pickups[event.detail]++;
+                break;
+            case GameEventType::LIFE_LOST:
+                level.livesLost++;
+                break;
+            case GameEventType::LEVEL_START:
+                closeLevel(event.step);
+                currentLevel = event.value;
+                run->level = std::max(run->level, event.value);
+                break;
+            case GameEventType::GAME_OVER:
+                closeLevel(event.step);
+                run->over = true;
+                run->won = event.detail != 0;
+                run->score = event.value;
+                run->endStep = event.step;
+                break;
+            default:
+                break;
+        }
+    }
+    if (!runs.empty() && !runs.back().over && !events.empty()) {
+        closeLevel(events.back().step);
+        runs.back().endStep = events.back().step;
+    }
+
+    char started[64] = "unknown";
+    std::time_t startTime = static_cast<std::time_t>(log.startTime);
+    if (const std::tm* utc = std::gmtime(&startTime)) std::strftime(started, sizeof(started), "%Y-%m-%d %H:%M:%S UTC", utc);
+    std::printf("seed %u, started %s, %zu events (%zu after rewinds)%s\n", log.seed, started, log.events.size(),
+                events.size(), log.truncated ? ", last block cut short" : "");
+
+    std::printf("\nruns\n");
+    for (size_t i = 0; i < runs.size(); i++) {
+        const RunStats& run = runs[i];
+        std::printf("  %3zu  score %8d  level %d  %-8s %8.1f s\n", i + 1, run.score, run.level,
+                    run.over ? (run.won ? "won" : "lost") : "unended", (run.endStep - run.startStep) / STEPS_PER_SECOND);
+    }
+
+    std::printf("\nlevel     time_s  kills  kills/min    points  lives_lost  bosses  combos  mean_combo  best_combo");
+    for (const char* name : POWER_UP_NAMES) std::printf("  %s", name);
+    std::printf("\n");
+    for (const auto& [number, level] : levels) {
+        double seconds = level.steps / STEPS_PER_SECOND;
+        std::printf("%5d  %9.1f  %5d  %9.1f  %8lld  %10d  %6d  %6d  %10.1f  %10d", number, seconds, level.kills,
+                    seconds > 0 ? level.kills * 60.0 / seconds : 0.0, static_cast<long long>(level.points),
+                    level.livesLost, level.bossesDefeated, level.combos,
+                    level.combos ? static_cast<double>(level.comboKills) / level.combos : 0.0, level.longestCombo);
+        for (int type = 0; type < POWER_UP_TYPES; type++) {
+            std::printf("  %*d", static_cast<int>(std::string(POWER_UP_NAMES[type]).size()), level.pickups[type]);
+        }
+        std::printf("\n");
+    }
+
+    std::printf("\nkills by archetype (wave file order)\n");
+    for (const auto& [archetype, kills] : killsByArchetype) std::printf("  %3d  %d\n", archetype, kills);
+}
+
+int main(int argc, char* argv[]) {
+    bool csv = argc == 3 && std::string(argv[1]) == "--csv";
+    if (argc != 2 && !csv) {
+        std::fprintf(stderr, "usage: eventlog [--csv] FILE.nsel\n");
+        return 1;
+    }
+
+    const char* path = argv[argc - 1];
+    EventLogFile log;
+    if (!log.load(path)) {
+        std::fprintf(stderr, "could not read event log %s\n", path);
+        return 1;
+    }
+    if (csv) {
+        printCsv(log);
+    } else {
+        printSummary(log);
+    }
+    return 0;
+}
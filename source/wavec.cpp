@@ -0,0 +1,290 @@
+// Wave compiler: turns a text level description into a .nsaw wave file.
+//
+// Usage: wavec INPUT.txt OUTPUT.nsaw
+//        wavec --dump FILE.nsaw
+//
+// Input format, one definition per line, '#' starts a comment:
+//
+//   archetype NAME size W H color R G B [A] outline T
+//             (speed SCALE | fixed_speed S) health H [health_per_level N]
+//             points P [bonus B] spawn_y Y [boss] [ends_game]
+//   level speed S interval SECONDS kills N mix NAME PERCENT [NAME PERCENT ...]
+//         [boss NAME]
+//
+// Archetypes must be defined before the levels that use them. Levels are
+// numbered in file order from 1, and each mix must add up to 100.
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "WaveFile.hpp"
+
+struct WaveSource {
+    std::vector<std::string> archetypeNames;
+    std::vector<EnemyArchetype> archetypes;
+    std::vector<LevelDef> levels;
+};
+
+// Reports a problem on line `lineNumber` and returns false
+static bool fail(int lineNumber, const std::string& message) {
+    std::cerr << "line " << lineNumber << ": " << message << "\n";
+    return false;
+}
+
+static int findArchetype(const WaveSource& source, const std::string& name) {
+    for (size_t i = 0; i < source.archetypeNames.size(); i++) {
+        if (source.archetypeNames[i] == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// Words of one line, consumed left to right
+class Tokens {
+public:
+    explicit Tokens(const std::string& line) {
+        std::istringstream in(line);
+        std::string word;
+        while (in >> word) words.push_back(word);
+    }
+
+    bool done() const { return next >= words.size(); }
+    std::string word() { return done() ? std::string() : words[next++]; }
+
+    // Reads a number into `value`; false if the next word isn't one
+    template <typename T>
+    bool number(T& value) {
+        if (done()) return false;
+        std::istringstream in(words[next]);
+        double parsed;
+        if (!(in >> parsed) || !in.eof()) return false;
+        value = static_cast<T>(parsed);
+        next++;
+        return true;
+    }
+
+    // Whether the word `ahead` words on is a number
+    bool isNumber(size_t ahead = 0) const {
+        if (next + ahead >= words.size()) return false;
+        std::istringstream in(words[next + ahead]);
+        double parsed;
+        return (in >> parsed) && in.eof();
+    }
+
+private:
+    std::vector<std::string> words;
+    size_t next = 0;
+};
+
+static bool parseArchetype(Tokens& in, int lineNumber, WaveSource& source) {
+    std::string name = in.word();
+    if (name.empty()) return fail(lineNumber, "archetype needs a name");
+    if (findArchetype(source, name) >= 0) return fail(lineNumber, "archetype " + name + " defined twice");
+
+    EnemyArchetype archetype{};
+    archetype.color[3] = 255;
+    archetype.speedScale = 1.0f;
+    bool hasSize = false, hasHealth = false, hasPoints = false;
+
+    while (!in.done()) {
+        std::string key = in.word();
+        bool ok = true;
+        if (key == "size") {
+            ok = in.number(archetype.width) && in.number(archetype.height);
+            hasSize = true;
+        } else if (key == "color") {
+            int r = 0, g = 0, b = 0, a = 255;
+            ok = in.number(r) && in.number(g) && in.number(b);
+            if (in.isNumber()) in.number(a);
+            archetype.color[0] = static_cast<uint8_t>(r);
+            archetype.color[1] = static_cast<uint8_t>(g);
+            archetype.color[2] = static_cast<uint8_t>(b);
+            archetype.color[3] = static_cast<uint8_t>(a);
+        } else if (key == "outline") {
+            ok = in.number(archetype.outline);
+        } else if (key == "speed") {
+            ok = in.number(archetype.speedScale);
+        } else if (key == "fixed_speed") {
+            ok = in.number(archetype.fixedSpeed);
+        } else if (key == "health") {
+            ok = in.number(archetype.health);
+            hasHealth = true;
+        } else if (key == "health_per_level") {
+            ok = in.number(archetype.healthPerLevel);
+        } else if (key == "points") {
+            ok = in.number(archetype.points);
+            hasPoints = true;
+        } else if (key == "bonus") {
+            ok = in.number(archetype.bonus);
+        } else if (key == "spawn_y") {
+            ok = in.number(archetype.spawnY);
+        } else if (key == "boss") {
+            archetype.flags |= ARCHETYPE_BOSS;
+        } else if (key == "ends_game") {
+            archetype.flags |= ARCHETYPE_ENDS_GAME;
+        } else {
+            return fail(lineNumber, "unknown archetype field " + key);
+        }
+        if (!ok) return fail(lineNumber, "bad value for " + key);
+    }
+
+    if (!hasSize || !hasHealth || !hasPoints) return fail(lineNumber, "archetype needs size, health and points");
+    if (archetype.health <= 0) return fail(lineNumber, "health must be positive");
+    if (source.archetypes.size() == 255) return fail(lineNumber, "too many archetypes");
+
+    source.archetypeNames.push_back(name);
+    source.archetypes.push_back(archetype);
+    return true;
+}
+
+static bool parseLevel(Tokens& in, int lineNumber, WaveSource& source) {
+    LevelDef level{};
+    level.bossArchetype = -1;
+    bool hasSpeed = false, hasInterval = false, hasKills = false;
+    int roll = 0;
+
+    while (!in.done()) {
+        std::string key = in.word();
+        bool ok = true;
+        if (key == "speed") {
+            ok = in.number(level.enemySpeed);
+            hasSpeed = true;
+        } else if (key == "interval") {
+            ok = in.number(level.spawnInterval);
+            hasInterval = true;
+        } else if (key == "kills") {
+            ok = in.number(level.killsToAdvance);
+            hasKills = true;
+        } else if (key == "boss") {
+            std::string name = in.word();
+            level.bossArchetype = findArchetype(source, name);
+            if (level.bossArchetype < 0) return fail(lineNumber, "unknown archetype '" + name + "'");
+        } else if (key == "mix") {
+            // NAME PERCENT pairs, up to the next field
+            while (!in.done() && in.isNumber(1)) {
+                std::string name = in.word();
+                if (findArchetype(source, name) < 0) return fail(lineNumber, "unknown archetype '" + name + "'");
+                int percent = 0;
+                if (!in.number(percent) || percent < 0) return fail(lineNumber, "bad percentage for " + name);
+                if (roll + percent > SPAWN_TABLE_SIZE) return fail(lineNumber, "mix adds up to more than 100");
+                uint8_t type = static_cast<uint8_t>(findArchetype(source, name));
+                for (int i = 0; i < percent; i++) level.spawnTable[roll++] = type;
+            }
+        } else {
+            return fail(lineNumber, "unknown level field " + key);
+        }
+        if (!ok) return fail(lineNumber, "bad value for " + key);
+    }
+
+    if (!hasSpeed || !hasInterval || !hasKills) return fail(lineNumber, "level needs speed, interval and kills");
+    if (level.spawnInterval <= 0) return fail(lineNumber, "interval must be positive");
+    if (roll != SPAWN_TABLE_SIZE) return fail(lineNumber, "mix must add up to 100");
+
+    source.levels.push_back(level);
+    return true;
+}
+
+static bool parseSource(std::istream& file, WaveSource& source) {
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        Tokens in(line);
+        if (in.done()) continue;
+        std::string kind = in.word();
+
+        if (kind == "archetype") {
+            if (!parseArchetype(in, lineNumber, source)) return false;
+        } else if (kind == "level") {
+            if (!parseLevel(in, lineNumber, source)) return false;
+        } else {
+            return fail(lineNumber, "expected 'archetype' or 'level', got " + kind);
+        }
+    }
+    if (source.archetypes.empty() || source.levels.empty()) {
+        std::cerr << "need at least one archetype and one level\n";
+        return false;
+    }
+    return true;
+}
+
+static std::vector<uint8_t> encode(const WaveSource& source) {
+    WaveFileHeader header{};
+    std::memcpy(header.magic, "NSAW", 4);
+    header.version = WAVE_FILE_VERSION;
+    header.archetypeCount = static_cast<uint32_t>(source.archetypes.size());
+    header.archetypeOffset = sizeof(WaveFileHeader);
+    header.levelCount = static_cast<uint32_t>(source.levels.size());
+    header.levelOffset = header.archetypeOffset + header.archetypeCount * sizeof(EnemyArchetype);
+    header.fileSize = header.levelOffset + header.levelCount * sizeof(LevelDef);
+
+    std::vector<uint8_t> bytes(header.fileSize);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    std::memcpy(bytes.data() + header.archetypeOffset, source.archetypes.data(), header.archetypeCount * sizeof(EnemyArchetype));
+    std::memcpy(bytes.data() + header.levelOffset, source.levels.data(), header.levelCount * sizeof(LevelDef));
+    return bytes;
+}
+
+static int dump(const std::string& path) {
+    WaveFile waves;
+    std::string error;
+    if (!waves.open(path, &error)) {
+        std::cerr << path << ": " << error << "\n";
+        return 1;
+    }
+    for (int i = 0; i < waves.archetypeCount(); i++) {
+        const EnemyArchetype& a = waves.archetype(i);
+        std::cout << "archetype " << i << ": size " << a.width << "x" << a.height << " color " << int(a.color[0]) << ","
+                  << int(a.color[1]) << "," << int(a.color[2]) << "," << int(a.color[3]) << " outline " << a.outline
+                  << " speed " << a.speedScale << " fixed " << a.fixedSpeed << " health " << a.health << "+"
+                  << a.healthPerLevel << "/level points " << a.points << " bonus " << a.bonus << " spawn_y " << a.spawnY
+                  << " flags " << a.flags << "\n";
+    }
+    for (int n = 1; n <= waves.levelCount(); n++) {
+        const LevelDef& level = waves.level(n);
+        int counts[256] = {};
+        for (uint8_t type : level.spawnTable) counts[type]++;
+        std::cout << "level " << n << ": speed " << level.enemySpeed << " interval " << level.spawnInterval << " kills "
+                  << level.killsToAdvance << " boss " << level.bossArchetype << " mix";
+        for (int i = 0; i < waves.archetypeCount(); i++) {
+            if (counts[i]) std::cout << " " << i << ":" << counts[i] << "%";
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--dump") return dump(argv[2]);
+    if (argc != 3) {
+        std::cerr << "usage: wavec INPUT.txt OUTPUT.nsaw\n       wavec --dump FILE.nsaw\n";
+        return 1;
+    }
+
+    std::ifstream input(argv[1]);
+    if (!input) {
+        std::cerr << "could not read " << argv[1] << "\n";
+        return 1;
+    }
+    WaveSource source;
+    if (!parseSource(input, source)) return 1;
+
+    std::vector<uint8_t> bytes = encode(source);
+    if (const char* problem = validateWaveData(bytes.data(), bytes.size())) {
+        std::cerr << "internal error: " << problem << "\n";
+        return 1;
+    }
+
+    std::ofstream output(argv[2], std::ios::binary);
+    output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!output) {
+        std::cerr << "could not write " << argv[2] << "\n";
+        return 1;
+    }
+    std::cout << argv[2] << ": " << source.archetypes.size() << " archetypes, " << source.levels.size()
+              << " levels, " << bytes.size() << " bytes\n";
+    return 0;
+}